@@ -11,9 +11,10 @@ void displayMenu()
     printf("| 2. Quick Sort                                                |\n");
     printf("| 3. Heap Sort                                                 |\n");
     printf("| 4. All Algorithms                                            |\n");
-    printf("| 5. Exit                                                      |\n");
+    printf("| 5. Selection (k-th / Median / Top-k)                         |\n");
+    printf("| 6. Exit                                                      |\n");
     printf("+--------------------------------------------------------------+\n");
-    printf("Enter your choice (1-5): ");
+    printf("Enter your choice (1-6): ");
 }
 
 void runMergeSort(int arr[], int n)
@@ -49,6 +50,43 @@ void runHeapSort(int arr[], int n)
     printArray(arrCopy, n);
 }
 
+void runSelection(int arr[], int n)
+{
+    int k;
+    printf("Enter k (1-%d): ", n);
+    scanf("%d", &k);
+    if (k < 1 || k > n) {
+        printf("Invalid k!\n");
+        return;
+    }
+
+    int arrCopy[n];
+    for (int i = 0; i < n; i++) arrCopy[i] = arr[i];
+
+    printHeader("INTROSELECT - K-TH SMALLEST", arrCopy, n);
+    int kth = nthElement(arrCopy, n, k - 1);
+    printFooter();
+    printf("%d-th smallest element: %d\n", k, kth);
+
+    for (int i = 0; i < n; i++) arrCopy[i] = arr[i];
+    printf("Median element: %d\n", selectMedian(arrCopy, n));
+
+    TopK *top = topKCreate(k);
+    if (top == NULL) {
+        printf("Memory allocation failed!\n");
+        return;
+    }
+    setSortVisualization(0);
+    for (int i = 0; i < n; i++) topKPush(top, arr[i]);
+    topKResult(top, arrCopy);
+    setSortVisualization(1);
+    topKDestroy(top);
+
+    printf("Top %d elements: ", k);
+    for (int i = 0; i < k; i++) printf("%d ", arrCopy[i]);
+    printf("\n");
+}
+
 int main()
 {
     int n, choice;
@@ -98,12 +136,15 @@ int main()
                 runHeapSort(arr, n);
                 break;
             case 5:
+                runSelection(arr, n);
+                break;
+            case 6:
                 printf("\nExiting program...\n");
                 break;
             default:
                 printf("Invalid choice! Please try again.\n");
         }
-    } while (choice != 5);
+    } while (choice != 6);
     
     free(arr);
     return 0;
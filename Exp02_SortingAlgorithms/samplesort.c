@@ -0,0 +1,476 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sorting.h"
+
+/*
+   Parallel in-place sample sort (IPS4o style)
+
+   One distribution step over arr[0..n-1]:
+     1. Sample    - oversampled random keys give up to 127 splitters;
+                    every splitter also gets an equality bucket, so runs
+                    of duplicate keys are finished in a single pass
+     2. Classify  - each thread streams its stripe into per-bucket block
+                    buffers and flushes full blocks back over the part of
+                    the stripe it has already read
+     3. Permute   - full blocks are swapped into their bucket's region,
+                    bucket read/write pointers guarded by per-bucket locks
+     4. Cleanup   - bucket borders are fixed up and the partially filled
+                    buffers are written into the remaining gaps
+
+   Extra memory is O(threads * buckets * block), independent of n.
+   Buckets are then sorted recursively in parallel; short ranges use
+   introSort (partitionQS + heapSort).
+*/
+
+#define SS_BLOCK        512                     // elements per block (2 KiB)
+#define SS_MAX_SPLIT    127
+#define SS_MAX_BUCKETS  (2 * SS_MAX_SPLIT + 1)
+#define SS_BASE_CASE    (16 * SS_BLOCK)
+
+typedef struct
+{
+    int tree[SS_MAX_SPLIT + 1];         // implicit search tree, root at 1
+    int splitters[SS_MAX_SPLIT];        // same keys in sorted order
+    int numSplitters;                   // always 2^levels - 1
+    int levels;
+    int numBuckets;
+} Classifier;
+
+typedef struct SampleSortStep SampleSortStep;
+
+typedef struct
+{
+    SampleSortStep *step;
+    int id;
+    long stripeBegin, stripeEnd;
+    long flushedEnd;                    // end of full blocks within the stripe
+    int *buffer;                        // numBuckets * SS_BLOCK
+    int fill[SS_MAX_BUCKETS];
+    long fullBlocks[SS_MAX_BUCKETS];
+    int swapBuffer[2][SS_BLOCK];
+} StripeState;
+
+struct SampleSortStep
+{
+    int *arr;
+    long n;
+    int threads;
+    Classifier cls;
+    StripeState *stripes;
+
+    long bucketBegin[SS_MAX_BUCKETS + 1];   // exact final bucket borders
+    long slotBegin[SS_MAX_BUCKETS + 1];     // borders rounded up to blocks
+    long write[SS_MAX_BUCKETS];
+    long read[SS_MAX_BUCKETS];
+    pthread_mutex_t lock[SS_MAX_BUCKETS];
+
+    int overflow[SS_BLOCK];             // block slot that would cross arr[n]
+    int overflowBucket;
+};
+
+// ================= CLASSIFICATION =================
+// Branch-free descent: i ends up as the number of splitters below x
+static inline int classify(const Classifier *cls, int x)
+{
+    int b = 1;
+    for (int l = 0; l < cls->levels; l++)
+        b = 2 * b + (cls->tree[b] < x);
+
+    int i = b - (cls->numSplitters + 1);
+    return 2 * i + (i < cls->numSplitters && cls->splitters[i] == x);
+}
+
+static void fillTree(Classifier *cls, int node, int *next)
+{
+    if (node > cls->numSplitters) return;
+    fillTree(cls, 2 * node, next);
+    cls->tree[node] = cls->splitters[(*next)++];
+    fillTree(cls, 2 * node + 1, next);
+}
+
+static unsigned long nextRandom(unsigned long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void buildClassifier(int arr[], long n, Classifier *cls)
+{
+    long target = n / (4 * SS_BLOCK) - 1;
+    if (target > SS_MAX_SPLIT) target = SS_MAX_SPLIT;
+    if (target < 1) target = 1;
+
+    int logn = 0;
+    for (long m = n; m > 1; m >>= 1) logn++;
+    long oversample = logn / 5 > 1 ? logn / 5 : 1;
+
+    long sampleSize = oversample * (target + 1) - 1;
+    if (sampleSize > n / 2) sampleSize = n / 2;
+
+    // Move a random sample to the front; it is classified like any other key
+    unsigned long state = 88172645463325252UL ^ (unsigned long)n;
+    for (long i = 0; i < sampleSize; i++)
+    {
+        long j = i + (long)(nextRandom(&state) % (unsigned long)(n - i));
+        int temp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = temp;
+    }
+    introSort(arr, (int)sampleSize);
+
+    int unique = 0;
+    for (long i = 1; i <= target; i++)
+    {
+        int splitter = arr[i * sampleSize / (target + 1)];
+        if (unique == 0 || cls->splitters[unique - 1] != splitter)
+            cls->splitters[unique++] = splitter;
+    }
+
+    // Pad with the largest splitter up to a full tree; the padded
+    // buckets just stay empty
+    cls->levels = 0;
+    while ((1 << cls->levels) - 1 < unique) cls->levels++;
+    cls->numSplitters = (1 << cls->levels) - 1;
+    for (int i = unique; i < cls->numSplitters; i++)
+        cls->splitters[i] = cls->splitters[unique - 1];
+
+    int next = 0;
+    fillTree(cls, 1, &next);
+    cls->numBuckets = 2 * cls->numSplitters + 1;
+}
+
+static void *classifyStripe(void *arg)
+{
+    StripeState *t = (StripeState *)arg;
+    SampleSortStep *s = t->step;
+
+    memset(t->fill, 0, sizeof(t->fill));
+    memset(t->fullBlocks, 0, sizeof(t->fullBlocks));
+
+    long write = t->stripeBegin;
+    for (long i = t->stripeBegin; i < t->stripeEnd; i++)
+    {
+        int x = s->arr[i];
+        int b = classify(&s->cls, x);
+        int *block = t->buffer + (long)b * SS_BLOCK;
+
+        block[t->fill[b]++] = x;
+        if (t->fill[b] == SS_BLOCK)
+        {
+            // Everything up to i has been read, so write <= i + 1 - SS_BLOCK
+            memcpy(s->arr + write, block, SS_BLOCK * sizeof(int));
+            write += SS_BLOCK;
+            t->fill[b] = 0;
+            t->fullBlocks[b]++;
+        }
+    }
+    t->flushedEnd = write;
+    return NULL;
+}
+
+// ================= BLOCK PERMUTATION =================
+static void placeBlock(SampleSortStep *s, long slot, int dest, const int *block)
+{
+    if (slot + SS_BLOCK > s->n)
+    {
+        memcpy(s->overflow, block, SS_BLOCK * sizeof(int));
+        s->overflowBucket = dest;
+    }
+    else
+    {
+        memcpy(s->arr + slot, block, SS_BLOCK * sizeof(int));
+    }
+}
+
+static void *permuteBlocks(void *arg)
+{
+    StripeState *t = (StripeState *)arg;
+    SampleSortStep *s = t->step;
+    int numBuckets = s->cls.numBuckets;
+    int first = (int)((long)t->id * numBuckets / s->threads);
+
+    for (int i = 0; i < numBuckets; i++)
+    {
+        int primary = (first + i) % numBuckets;
+
+        for (;;)
+        {
+            int *current = t->swapBuffer[0];
+            int *other = t->swapBuffer[1];
+
+            // Take one unprocessed block out of the primary bucket
+            pthread_mutex_lock(&s->lock[primary]);
+            if (s->read[primary] < s->write[primary])
+            {
+                pthread_mutex_unlock(&s->lock[primary]);
+                break;
+            }
+            memcpy(current, s->arr + s->read[primary], SS_BLOCK * sizeof(int));
+            s->read[primary] -= SS_BLOCK;
+            pthread_mutex_unlock(&s->lock[primary]);
+
+            // Follow the swap chain until a block lands in an empty slot
+            for (;;)
+            {
+                int dest = classify(&s->cls, current[0]);
+
+                pthread_mutex_lock(&s->lock[dest]);
+                long slot = s->write[dest];
+                s->write[dest] += SS_BLOCK;
+
+                if (slot > s->read[dest])
+                {
+                    placeBlock(s, slot, dest, current);
+                    pthread_mutex_unlock(&s->lock[dest]);
+                    break;
+                }
+
+                memcpy(other, s->arr + slot, SS_BLOCK * sizeof(int));
+                memcpy(s->arr + slot, current, SS_BLOCK * sizeof(int));
+                pthread_mutex_unlock(&s->lock[dest]);
+
+                int *temp = current;
+                current = other;
+                other = temp;
+            }
+        }
+    }
+    return NULL;
+}
+
+// ================= DISTRIBUTION STEP =================
+static void runThreads(SampleSortStep *s, void *(*fn)(void *))
+{
+    pthread_t tid[s->threads];
+
+    for (int t = 1; t < s->threads; t++)
+        pthread_create(&tid[t], NULL, fn, &s->stripes[t]);
+    fn(&s->stripes[0]);
+    for (int t = 1; t < s->threads; t++)
+        pthread_join(tid[t], NULL);
+}
+
+// Moves leftover buffer contents (and the overflow block) of bucket b
+// into the gaps around its full blocks
+static void cleanupBucket(SampleSortStep *s, int b, int *scratch)
+{
+    long begin = s->bucketBegin[b];
+    long end = s->bucketBegin[b + 1];
+    long blocksBegin = s->slotBegin[b];
+    long blocksEnd = s->write[b];
+    long pending = 0;
+
+    for (int t = 0; t < s->threads; t++)
+    {
+        StripeState *st = &s->stripes[t];
+        memcpy(scratch + pending, st->buffer + (long)b * SS_BLOCK,
+               st->fill[b] * sizeof(int));
+        pending += st->fill[b];
+    }
+    if (s->overflowBucket == b)
+    {
+        blocksEnd -= SS_BLOCK;
+        memcpy(scratch + pending, s->overflow, SS_BLOCK * sizeof(int));
+        pending += SS_BLOCK;
+    }
+
+    if (blocksEnd == blocksBegin)
+    {
+        memcpy(s->arr + begin, scratch, pending * sizeof(int));
+        return;
+    }
+
+    // The last block may reach into the next bucket; its tail moves to
+    // the head of this bucket, which the previous bucket no longer needs
+    long head = begin;
+    if (blocksEnd > end)
+    {
+        memcpy(s->arr + head, s->arr + end, (blocksEnd - end) * sizeof(int));
+        head += blocksEnd - end;
+        blocksEnd = end;
+    }
+
+    long used = 0;
+    memcpy(s->arr + head, scratch, (blocksBegin - head) * sizeof(int));
+    used += blocksBegin - head;
+    memcpy(s->arr + blocksEnd, scratch + used, (end - blocksEnd) * sizeof(int));
+}
+
+static int distribute(int arr[], long n, int threads, long bucketBegin[])
+{
+    SampleSortStep *s = (SampleSortStep *)malloc(sizeof(SampleSortStep));
+    StripeState *stripes = (StripeState *)malloc(threads * sizeof(StripeState));
+    int *buffers = NULL;
+    int *scratch = NULL;
+
+    if (s != NULL && stripes != NULL)
+    {
+        buildClassifier(arr, n, &s->cls);
+        buffers = (int *)malloc((size_t)threads * s->cls.numBuckets * SS_BLOCK * sizeof(int));
+        scratch = (int *)malloc((size_t)(threads + 1) * SS_BLOCK * sizeof(int));
+    }
+    if (buffers == NULL || scratch == NULL)
+    {
+        free(scratch);
+        free(buffers);
+        free(stripes);
+        free(s);
+        return 0;
+    }
+
+    s->arr = arr;
+    s->n = n;
+    s->threads = threads;
+    s->stripes = stripes;
+    s->overflowBucket = -1;
+    int numBuckets = s->cls.numBuckets;
+
+    for (int t = 0; t < threads; t++)
+    {
+        stripes[t].step = s;
+        stripes[t].id = t;
+        stripes[t].stripeBegin = n * t / threads;
+        stripes[t].stripeEnd = n * (t + 1) / threads;
+        stripes[t].buffer = buffers + (long)t * numBuckets * SS_BLOCK;
+    }
+    runThreads(s, classifyStripe);
+
+    // Gather the full blocks at the front, stripe by stripe
+    long fullEnd = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        long len = stripes[t].flushedEnd - stripes[t].stripeBegin;
+        memmove(arr + fullEnd, arr + stripes[t].stripeBegin, len * sizeof(int));
+        fullEnd += len;
+    }
+
+    s->bucketBegin[0] = 0;
+    for (int b = 0; b < numBuckets; b++)
+    {
+        long size = 0;
+        for (int t = 0; t < threads; t++)
+            size += stripes[t].fullBlocks[b] * SS_BLOCK + stripes[t].fill[b];
+        s->bucketBegin[b + 1] = s->bucketBegin[b] + size;
+    }
+    for (int b = 0; b <= numBuckets; b++)
+        s->slotBegin[b] = (s->bucketBegin[b] + SS_BLOCK - 1) / SS_BLOCK * SS_BLOCK;
+
+    for (int b = 0; b < numBuckets; b++)
+    {
+        long lastFull = s->slotBegin[b + 1] < fullEnd ? s->slotBegin[b + 1] : fullEnd;
+        s->write[b] = s->slotBegin[b];
+        s->read[b] = lastFull - SS_BLOCK;
+        pthread_mutex_init(&s->lock[b], NULL);
+    }
+    runThreads(s, permuteBlocks);
+
+    for (int b = 0; b < numBuckets; b++)
+    {
+        cleanupBucket(s, b, scratch);
+        pthread_mutex_destroy(&s->lock[b]);
+    }
+
+    memcpy(bucketBegin, s->bucketBegin, (numBuckets + 1) * sizeof(long));
+
+    free(scratch);
+    free(buffers);
+    free(stripes);
+    free(s);
+    return numBuckets;
+}
+
+// ================= RECURSION =================
+typedef struct
+{
+    int *arr;
+    const long *ranges;     // [begin, end) pairs
+    int count;
+    int next;
+    pthread_mutex_t lock;
+} BucketQueue;
+
+static void sampleSortRange(int arr[], long n, int threads);
+
+static void *sortQueuedBuckets(void *arg)
+{
+    BucketQueue *q = (BucketQueue *)arg;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&q->lock);
+        int i = q->next;
+        q->next += 2;
+        pthread_mutex_unlock(&q->lock);
+
+        if (i >= q->count) break;
+        sampleSortRange(q->arr + q->ranges[i], q->ranges[i + 1] - q->ranges[i], 1);
+    }
+    return NULL;
+}
+
+static void sampleSortRange(int arr[], long n, int threads)
+{
+    if (n <= SS_BASE_CASE)
+    {
+        introSort(arr, (int)n);
+        return;
+    }
+
+    long bucketBegin[SS_MAX_BUCKETS + 1];
+    int numBuckets = distribute(arr, n, threads, bucketBegin);
+    if (numBuckets == 0)
+    {
+        introSort(arr, (int)n);   // out of memory: sort in place sequentially
+        return;
+    }
+
+    // Odd buckets hold keys equal to a splitter and are already sorted
+    if (threads == 1)
+    {
+        for (int b = 0; b < numBuckets; b += 2)
+            sampleSortRange(arr + bucketBegin[b], bucketBegin[b + 1] - bucketBegin[b], 1);
+        return;
+    }
+
+    // Oversized buckets keep all threads; the rest are shared out one per thread
+    for (int b = 0; b < numBuckets; b += 2)
+    {
+        long size = bucketBegin[b + 1] - bucketBegin[b];
+        if (size > n / threads)
+            sampleSortRange(arr + bucketBegin[b], size, threads);
+    }
+
+    long ranges[SS_MAX_BUCKETS + 1];
+    int count = 0;
+    for (int b = 0; b < numBuckets; b += 2)
+    {
+        if (bucketBegin[b + 1] - bucketBegin[b] <= n / threads)
+        {
+            ranges[count++] = bucketBegin[b];
+            ranges[count++] = bucketBegin[b + 1];
+        }
+    }
+
+    BucketQueue q = { arr, ranges, count, 0, PTHREAD_MUTEX_INITIALIZER };
+    pthread_t tid[threads];
+    for (int t = 1; t < threads; t++)
+        pthread_create(&tid[t], NULL, sortQueuedBuckets, &q);
+    sortQueuedBuckets(&q);
+    for (int t = 1; t < threads; t++)
+        pthread_join(tid[t], NULL);
+}
+
+void parallelSampleSort(int arr[], int n, int threads)
+{
+    if (n < 2) return;
+    if (threads < 1) threads = 1;
+
+    // Step tracing is not thread-safe and would swamp the output anyway
+    int previous = setSortVisualization(0);
+    sampleSortRange(arr, n, threads);
+    setSortVisualization(previous);
+}
@@ -1,9 +1,21 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "sorting.h"
 
+// Step tracing is on for the interactive visualizer; bulk callers turn it off
+static int visualize = 1;
+
+int setSortVisualization(int enabled)
+{
+    int previous = visualize;
+    visualize = enabled;
+    return previous;
+}
+
 // ================= PRINT UTILITY =================
 void printArrayStep(const char *msg, int arr[], int n)
 {
+    if (!visualize) return;
     printf("| %-25s| ", msg);
     for (int i = 0; i < n; i++)
         printf("%3d ", arr[i]);
@@ -12,6 +24,7 @@ void printArrayStep(const char *msg, int arr[], int n)
 
 void printDivider(void)
 {
+    if (!visualize) return;
     printf("+---------------------------");
     for (int i = 0; i < 50; i++) printf("-");
     printf("+\n");
@@ -100,8 +113,10 @@ int partitionQS(int arr[], int low, int high)
     int i = low - 1;
     
     char msg[50];
-    sprintf(msg, "Partition [%d-%d], pivot=%d", low, high, pivot);
-    printArrayStep(msg, arr + low, high - low + 1);
+    if (visualize) {
+        sprintf(msg, "Partition [%d-%d], pivot=%d", low, high, pivot);
+        printArrayStep(msg, arr + low, high - low + 1);
+    }
     
     for (int j = low; j < high; j++)
     {
@@ -112,7 +127,7 @@ int partitionQS(int arr[], int low, int high)
             arr[i] = arr[j];
             arr[j] = temp;
             
-            if (i != j) {
+            if (visualize && i != j) {
                 sprintf(msg, "Swap %d <-> %d", arr[i], arr[j]);
                 printArrayStep(msg, arr + low, high - low + 1);
             }
@@ -123,8 +138,10 @@ int partitionQS(int arr[], int low, int high)
     arr[i + 1] = arr[high];
     arr[high] = temp;
     
-    sprintf(msg, "Place pivot at %d", i + 1);
-    printArrayStep(msg, arr + low, high - low + 1);
+    if (visualize) {
+        sprintf(msg, "Place pivot at %d", i + 1);
+        printArrayStep(msg, arr + low, high - low + 1);
+    }
     
     return i + 1;
 }
@@ -164,9 +181,11 @@ void heapify(int arr[], int n, int i)
         arr[i] = arr[largest];
         arr[largest] = temp;
         
-        char msg[50];
-        sprintf(msg, "Heapify: swap %d <-> %d", arr[i], arr[largest]);
-        printArrayStep(msg, arr, n);
+        if (visualize) {
+            char msg[50];
+            sprintf(msg, "Heapify: swap %d <-> %d", arr[i], arr[largest]);
+            printArrayStep(msg, arr, n);
+        }
         
         heapify(arr, n, largest);
     }
@@ -191,14 +210,246 @@ void heapSort(int arr[], int n)
         arr[0] = arr[i];
         arr[i] = temp;
         
-        char msg[50];
-        sprintf(msg, "Extract max: %d", temp);
-        printArrayStep(msg, arr, n);
+        if (visualize) {
+            char msg[50];
+            sprintf(msg, "Extract max: %d", temp);
+            printArrayStep(msg, arr, n);
+        }
         
         heapify(arr, i, 0);
     }
 }
 
+// ================= SELECTION & PARTIAL SORT =================
+static void swapInt(int *a, int *b)
+{
+    int temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+static void insertionSortRange(int arr[], int low, int high)
+{
+    for (int i = low + 1; i <= high; i++)
+    {
+        int key = arr[i];
+        int j = i - 1;
+        while (j >= low && arr[j] > key)
+        {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = key;
+    }
+}
+
+static void selectRange(int arr[], int low, int high, int k, int budget);
+
+// Median of medians: guaranteed 30/70 split, used once quickselect degrades
+static int medianOfMediansPivot(int arr[], int low, int high)
+{
+    if (high - low < 5)
+    {
+        insertionSortRange(arr, low, high);
+        return low + (high - low) / 2;
+    }
+
+    int store = low;
+    for (int i = low; i <= high; i += 5)
+    {
+        int groupHigh = (i + 4 > high) ? high : i + 4;
+        insertionSortRange(arr, i, groupHigh);
+        swapInt(&arr[store++], &arr[i + (groupHigh - i) / 2]);
+    }
+
+    int mid = low + (store - 1 - low) / 2;
+    selectRange(arr, low, store - 1, mid, 0);
+    return mid;
+}
+
+static int medianOfThreePivot(int arr[], int low, int high)
+{
+    int mid = low + (high - low) / 2;
+    int a = arr[low], b = arr[mid], c = arr[high];
+
+    if ((a <= b && b <= c) || (c <= b && b <= a)) return mid;
+    if ((b <= a && a <= c) || (c <= a && a <= b)) return low;
+    return high;
+}
+
+// Introselect: quickselect on partitionQS until the budget of
+// partition rounds runs out, then median-of-medians pivots
+static void selectRange(int arr[], int low, int high, int k, int budget)
+{
+    while (high > low)
+    {
+        if (high - low < 16)
+        {
+            insertionSortRange(arr, low, high);
+            return;
+        }
+
+        int pivotIndex;
+        if (budget > 0)
+        {
+            pivotIndex = medianOfThreePivot(arr, low, high);
+            budget--;
+        }
+        else
+        {
+            pivotIndex = medianOfMediansPivot(arr, low, high);
+        }
+
+        swapInt(&arr[pivotIndex], &arr[high]);
+        int p = partitionQS(arr, low, high);
+
+        if (k == p) return;
+        if (k < p)
+        {
+            high = p - 1;
+            continue;
+        }
+
+        // partitionQS leaves keys equal to the pivot on the right;
+        // gather them next to it so duplicates cannot stall the loop
+        int equalEnd = p + 1;
+        for (int j = p + 1; j <= high; j++)
+        {
+            if (arr[j] == arr[p])
+                swapInt(&arr[equalEnd++], &arr[j]);
+        }
+        if (k < equalEnd) return;
+        low = equalEnd;
+    }
+}
+
+int nthElement(int arr[], int n, int k)
+{
+    int budget = 0;
+    for (int m = n; m > 1; m >>= 1)
+        budget += 2;
+
+    selectRange(arr, 0, n - 1, k, budget);
+    return arr[k];
+}
+
+int selectMedian(int arr[], int n)
+{
+    return nthElement(arr, n, (n - 1) / 2);
+}
+
+void partialSort(int arr[], int n, int k)
+{
+    if (k <= 0) return;
+    if (k < n)
+        nthElement(arr, n, k - 1);
+    else
+        k = n;
+
+    heapSort(arr, k);
+}
+
+// Introsort: quickSort's partition with median-of-three pivots, heapSort
+// once recursion gets too deep, insertion sort for short ranges
+static void introSortRange(int arr[], int low, int high, int depth)
+{
+    while (high - low >= 16)
+    {
+        if (depth == 0)
+        {
+            heapSort(arr + low, high - low + 1);
+            return;
+        }
+        depth--;
+
+        swapInt(&arr[medianOfThreePivot(arr, low, high)], &arr[high]);
+        int p = partitionQS(arr, low, high);
+
+        // Recurse on the smaller side to keep the stack logarithmic
+        if (p - low < high - p)
+        {
+            introSortRange(arr, low, p - 1, depth);
+            low = p + 1;
+        }
+        else
+        {
+            introSortRange(arr, p + 1, high, depth);
+            high = p - 1;
+        }
+    }
+    insertionSortRange(arr, low, high);
+}
+
+void introSort(int arr[], int n)
+{
+    int depth = 0;
+    for (int m = n; m > 1; m >>= 1)
+        depth += 2;
+
+    introSortRange(arr, 0, n - 1, depth);
+}
+
+// ================= STREAMING TOP-K =================
+// Keys are stored bitwise-complemented (~x reverses the order without
+// overflow), so the max-heap built by heapify keeps the smallest of the
+// k largest values at the root.
+TopK *topKCreate(int k)
+{
+    if (k <= 0) return NULL;
+
+    TopK *t = (TopK *)malloc(sizeof(TopK));
+    if (t == NULL) return NULL;
+
+    t->heap = (int *)malloc(k * sizeof(int));
+    if (t->heap == NULL)
+    {
+        free(t);
+        return NULL;
+    }
+    t->k = k;
+    t->size = 0;
+    return t;
+}
+
+void topKPush(TopK *t, int value)
+{
+    if (t->size < t->k)
+    {
+        t->heap[t->size++] = ~value;
+        if (t->size == t->k)
+        {
+            for (int i = t->k / 2 - 1; i >= 0; i--)
+                heapify(t->heap, t->k, i);
+        }
+        return;
+    }
+
+    if (~value < t->heap[0])
+    {
+        t->heap[0] = ~value;
+        heapify(t->heap, t->k, 0);
+    }
+}
+
+int topKResult(const TopK *t, int out[])
+{
+    for (int i = 0; i < t->size; i++)
+        out[i] = t->heap[i];
+
+    heapSort(out, t->size);
+    for (int i = 0; i < t->size; i++)
+        out[i] = ~out[i];
+
+    return t->size;
+}
+
+void topKDestroy(TopK *t)
+{
+    if (t == NULL) return;
+    free(t->heap);
+    free(t);
+}
+
 void printArray(int arr[], int n)
 {
     printf("+--------------------------------------------------------------+\n");
@@ -5,6 +5,28 @@
 void mergeSort(int arr[], int l, int r);
 void quickSort(int arr[], int low, int high);
 void heapSort(int arr[], int n);
+void introSort(int arr[], int n);
+
+// Parallel in-place sample sort (samplesort.c, link with -pthread)
+void parallelSampleSort(int arr[], int n, int threads);
+
+// Selection and partial sorting (k is a 0-based rank)
+int nthElement(int arr[], int n, int k);
+int selectMedian(int arr[], int n);
+void partialSort(int arr[], int n, int k);
+
+// Streaming top-k: keeps the k largest values seen so far
+typedef struct
+{
+    int *heap;
+    int k;
+    int size;
+} TopK;
+
+TopK *topKCreate(int k);
+void topKPush(TopK *t, int value);
+int topKResult(const TopK *t, int out[]);   // largest first, returns count
+void topKDestroy(TopK *t);
 
 // Visualization functions
 void printArray(int arr[], int n);
@@ -12,6 +34,7 @@ void printArrayStep(const char *msg, int arr[], int n);
 void printDivider(void);
 void printHeader(const char *title, int arr[], int n);
 void printFooter(void);
+int setSortVisualization(int enabled);   // returns previous setting
 
 // Helper functions for sorting algorithms
 int partitionQS(int arr[], int low, int high);
@@ -0,0 +1,95 @@
+#include "prims.h"
+
+// Matrix construction scaling benchmark.
+// Builds a dense city of N buildings and times calculateAllDistances and
+// calculateAllCosts for 1, 2, 4, ... threads, checking that every thread
+// count produces exactly the matrices of the single-threaded run.
+//
+// Usage: prims_benchmark [buildings] [max_threads]
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static CityGraph* buildBenchmarkCity(int building_count) {
+    CityGraph* graph = createCityGraph("Benchmark City", building_count);
+    if (!graph) return NULL;
+    
+    srand(42);
+    for (int i = 0; i < building_count; i++) {
+        char name[MAX_NAME_LEN];
+        sprintf(name, "Building %d", i);
+        double lat = 18.5 + (rand() % 100000) / 1000000.0;
+        double lon = 74.0 + (rand() % 100000) / 1000000.0;
+        addBuilding(graph, i, name, lat, lon, i == 0 ? DATA_CENTER : (BuildingType)(rand() % 5),
+                    100 + rand() % 1000);
+    }
+    for (int i = 1; i < building_count; i += 7) {
+        addConnection(graph, rand() % i, i, (TerrainType)(rand() % 5), true);
+    }
+    return graph;
+}
+
+int main(int argc, char* argv[]) {
+    int building_count = argc > 1 ? atoi(argv[1]) : 20000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : getMatrixThreadCount();
+    if (building_count < 2) building_count = 2;
+    if (max_threads < 1) max_threads = 1;
+    
+    CityGraph* graph = buildBenchmarkCity(building_count);
+    if (!graph) return 1;
+    
+    size_t pairs = pairCount(building_count);
+    float* reference_dist = (float*)malloc(pairs * sizeof(float));
+    float* reference_cost = (float*)malloc(pairs * sizeof(float));
+    float* explicit_costs = (float*)malloc(pairs * sizeof(float));
+    if (!reference_dist || !reference_cost || !explicit_costs) {
+        fprintf(stderr, "Memory allocation failed for benchmark\n");
+        return 1;
+    }
+    // calculateAllCosts only fills unset pairs, so restore them between runs
+    memcpy(explicit_costs, graph->adj_matrix, pairs * sizeof(float));
+    
+    printf("\nMatrix construction: %d buildings, %zu pairs, %s distance kernel\n",
+            building_count, pairs, getDistanceKernelName());
+    printf("┌─────────┬───────────────┬───────────────┬──────────┬────────────┐\n");
+    printf("│ Threads │ Distances (s) │ Costs (s)     │ Speedup  │ Identical  │\n");
+    printf("├─────────┼───────────────┼───────────────┼──────────┼────────────┤\n");
+    
+    double baseline = 0.0;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads) threads = max_threads;
+        setMatrixThreadCount(threads);
+        memcpy(graph->adj_matrix, explicit_costs, pairs * sizeof(float));
+        
+        struct timespec t0, t1, t2;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        calculateAllDistances(graph);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        calculateAllCosts(graph);
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        
+        double dist_time = elapsedSeconds(t0, t1);
+        double cost_time = elapsedSeconds(t1, t2);
+        bool identical = true;
+        if (threads == 1) {
+            baseline = dist_time + cost_time;
+            memcpy(reference_dist, graph->dist_matrix, pairs * sizeof(float));
+            memcpy(reference_cost, graph->adj_matrix, pairs * sizeof(float));
+        } else {
+            identical = memcmp(reference_dist, graph->dist_matrix, pairs * sizeof(float)) == 0 &&
+                        memcmp(reference_cost, graph->adj_matrix, pairs * sizeof(float)) == 0;
+        }
+        
+        printf("│ %7d │ %13.3f │ %13.3f │ %7.2fx │ %-10s │\n", threads, dist_time, cost_time,
+                baseline / (dist_time + cost_time), identical ? "yes" : "NO");
+        if (threads >= max_threads) break;
+    }
+    printf("└─────────┴───────────────┴───────────────┴──────────┴────────────┘\n");
+    
+    free(reference_dist);
+    free(reference_cost);
+    free(explicit_costs);
+    destroyCityGraph(graph);
+    return 0;
+}
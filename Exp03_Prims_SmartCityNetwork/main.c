@@ -1,5 +1,9 @@
 #include "prims.h"
+#include <ctype.h>
+#include <pthread.h>
+#ifdef _WIN32
 #include <conio.h>  // For Windows getch(), if Linux/Mac use appropriate alternative
+#endif
 
 // ===================== FUNCTION PROTOTYPES =====================
 void clearScreen();
@@ -180,20 +184,20 @@ void manualCityInput(CityGraph** graph) {
     fgets(city_name, sizeof(city_name), stdin);
     city_name[strcspn(city_name, "\n")] = 0;
     
-    printf("Enter number of buildings (max %d): ", MAX_BUILDINGS);
+    printf("Enter number of buildings: ");
     scanf("%d", &building_count);
     getchar(); // Clear newline
     
-    if (building_count > MAX_BUILDINGS) {
-        printf("Maximum capacity is %d. Setting to %d.\n", MAX_BUILDINGS, MAX_BUILDINGS);
-        building_count = MAX_BUILDINGS;
+    if (building_count < 1) {
+        printf("At least one building is required. Setting to 1.\n");
+        building_count = 1;
     }
     
     if (*graph) {
         destroyCityGraph(*graph);
     }
     
-    *graph = createCityGraph(city_name, MAX_BUILDINGS);
+    *graph = createCityGraph(city_name, building_count);
     
     if (!*graph) {
         printf("Failed to create city graph.\n");
@@ -295,7 +299,7 @@ void demoMode() {
             MSTResult* result = primMST(demo_city, demo_city->start_vertex);
             if (result) {
                 printMSTResult(demo_city, result);
-                free(result);
+                destroyMSTResult(result);
             }
         }
         
@@ -342,7 +346,7 @@ void runPrimsAlgorithm(CityGraph* graph, MSTResult** result) {
     
     // Free previous result if exists
     if (*result) {
-        free(*result);
+        destroyMSTResult(*result);
         *result = NULL;
     }
     
@@ -568,13 +572,478 @@ void displayHelp() {
     getchar();
 }
 
+// ===================== BATCH MODE =====================
+// prims_system [options] city.csv [more.csv ...] runs without menus: every
+// city is loaded, solved and written out by a pool of worker threads. One
+// summary line per city goes to stdout and per-phase timings to stderr, both
+// tab-separated and in input order, so jobs can be scripted and several
+// invocations run side by side.
+
+typedef enum {
+    BATCH_PRIM,         // Dense Prim, or Prim over the geometric candidates for sparse cities
+    BATCH_KRUSKAL,
+    BATCH_BORUVKA,
+    BATCH_GEOMETRIC
+} BatchAlgorithm;
+
+typedef struct {
+    BatchAlgorithm algorithm;
+    int start_vertex;         // -1 = the city's own start building
+    const char* output_dir;   // NULL = no output files
+    bool write_plan;
+    bool write_report;
+    bool write_binary;
+    int workers;              // Worker threads (cities processed at once)
+    int max_in_flight;        // Cities loaded but not finished, at most
+    int matrix_threads;       // Per-city matrix threads; 0 = share the CPUs
+} BatchOptions;
+
+static const char* BATCH_ALGORITHM_NAMES[] = {"prim", "kruskal", "boruvka", "geometric"};
+
+static double elapsedMs(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1000.0 + (now.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+// <output_dir>/<file name without directory and extension><suffix>
+static void batchOutputPath(char* path, size_t size, const char* output_dir,
+                            const char* city_file, const char* suffix) {
+    const char* base = city_file;
+    for (const char* c = city_file; *c; c++) {
+        if (*c == '/' || *c == '\\') base = c + 1;
+    }
+    const char* dot = strrchr(base, '.');
+    int stem = dot && dot != base ? (int)(dot - base) : (int)strlen(base);
+    snprintf(path, size, "%s/%.*s%s", output_dir, stem, base, suffix);
+}
+
+// ----- Job queue -----
+// Every city is a job that passes through the stages below in order. A
+// fixed pool of workers takes the next stage of any city that is waiting.
+// Cities already in flight are finished first, so at most max_in_flight
+// graphs are in memory at once. A worker starts a new city only when no
+// admitted city has work ready. Results are printed in input order as soon
+// as every earlier city has finished, so the output does not depend on
+// the number of workers.
+
+typedef enum {
+    STAGE_LOAD,         // Parse, plus the distance and cost matrices of dense cities
+    STAGE_MST,
+    STAGE_WRITE,
+    STAGE_DONE
+} BatchStage;
+
+static const char* BATCH_STAGE_NAMES[] = {"load", "mst", "write"};
+
+typedef struct {
+    const char* city_file;
+    BatchStage stage;           // Next stage to run
+    bool running;               // A worker is on it
+    bool failed;
+    CityGraph* graph;
+    MSTResult* result;
+    int start;
+    int buildings;
+    int links;
+    double total_cost;
+    double stage_ms[STAGE_DONE];
+} BatchJob;
+
+typedef struct {
+    BatchJob* jobs;
+    int count;
+    const BatchOptions* options;
+    int next_admit;             // First job not yet started
+    int next_report;            // First job not yet printed
+    int in_flight;              // Started and not finished
+    int max_in_flight;
+    int failed;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} BatchQueue;
+
+// Runs job->stage; returns false (after saying why) if the city failed
+static bool runBatchStage(BatchJob* job, const BatchOptions* options) {
+    switch (job->stage) {
+        case STAGE_LOAD: {
+            job->graph = loadCityFromCSV(job->city_file);
+            if (!job->graph || job->graph->vertex_count < 1) {
+                fprintf(stderr, "%s: could not load city\n", job->city_file);
+                return false;
+            }
+            // Cities without a data center have no start building; use the first one
+            job->start = options->start_vertex >= 0 ? options->start_vertex : job->graph->start_vertex;
+            if (job->start < 0) job->start = 0;
+            if (job->start >= job->graph->vertex_count) {
+                fprintf(stderr, "%s: start vertex %d out of range (0-%d)\n",
+                        job->city_file, job->start, job->graph->vertex_count - 1);
+                return false;
+            }
+            return true;
+        }
+        case STAGE_MST:
+            switch (options->algorithm) {
+                case BATCH_PRIM:      job->result = primMST(job->graph, job->start); break;
+                case BATCH_KRUSKAL:   job->result = kruskalMST(job->graph); break;
+                case BATCH_BORUVKA:   job->result = boruvkaMST(job->graph); break;
+                case BATCH_GEOMETRIC: job->result = primMSTGeometric(job->graph, job->start, 0); break;
+            }
+            if (!job->result) {
+                fprintf(stderr, "%s: %s failed\n", job->city_file, BATCH_ALGORITHM_NAMES[options->algorithm]);
+                return false;
+            }
+            job->buildings = job->graph->vertex_count;
+            job->links = job->result->connections_used;
+            job->total_cost = job->result->total_cost;
+            return true;
+        case STAGE_WRITE: {
+            char path[1024];
+            batchOutputPath(path, sizeof(path), options->output_dir, job->city_file, "_mst.csv");
+            saveMSTToCSV(job->graph, job->result, path);
+            if (options->write_plan) {
+                batchOutputPath(path, sizeof(path), options->output_dir, job->city_file, "_plan.txt");
+                saveNetworkPlan(job->graph, job->result, path);
+            }
+            if (options->write_report) {
+                batchOutputPath(path, sizeof(path), options->output_dir, job->city_file, "_report.txt");
+                generateReport(job->graph, job->result, path);
+            }
+            if (options->write_binary) {
+                batchOutputPath(path, sizeof(path), options->output_dir, job->city_file, "_mst.mstb");
+                saveMSTToBinary(job->graph, job->result, path);
+            }
+            return true;
+        }
+        case STAGE_DONE:
+            break;
+    }
+    return true;
+}
+
+// Caller holds the lock. Prefers the admitted city furthest along, then
+// the earliest one; admits a new city only if none has work ready.
+static BatchJob* nextBatchJob(BatchQueue* q) {
+    BatchJob* best = NULL;
+    for (int j = q->next_report; j < q->next_admit; j++) {
+        BatchJob* job = &q->jobs[j];
+        if (job->running || job->failed || job->stage == STAGE_DONE) continue;
+        if (!best || job->stage > best->stage) best = job;
+    }
+    if (!best && q->in_flight < q->max_in_flight && q->next_admit < q->count) {
+        best = &q->jobs[q->next_admit++];
+        q->in_flight++;
+    }
+    return best;
+}
+
+// Caller holds the lock. Prints every finished job that has no unfinished
+// job before it: phase timings to stderr, the summary line to stdout.
+static void reportFinishedJobs(BatchQueue* q) {
+    while (q->next_report < q->next_admit) {
+        BatchJob* job = &q->jobs[q->next_report];
+        if (job->running || (!job->failed && job->stage != STAGE_DONE)) break;
+        
+        double total = 0.0;
+        for (int s = STAGE_LOAD; s < STAGE_DONE; s++) {
+            if (job->stage_ms[s] < 0.0) continue;
+            fprintf(stderr, "%s\t%s\t%.3f ms\n", job->city_file, BATCH_STAGE_NAMES[s], job->stage_ms[s]);
+            total += job->stage_ms[s];
+        }
+        if (!job->failed) {
+            printf("%s\t%s\t%d\t%d\t%.4f\n", job->city_file, BATCH_ALGORITHM_NAMES[q->options->algorithm],
+                   job->buildings, job->links, job->total_cost);
+            fflush(stdout);
+            fprintf(stderr, "%s\ttotal\t%.3f ms\n", job->city_file, total);
+        }
+        q->next_report++;
+    }
+}
+
+static void* batchWorker(void* arg) {
+    BatchQueue* q = (BatchQueue*)arg;
+    
+    pthread_mutex_lock(&q->lock);
+    while (q->next_report < q->count) {
+        BatchJob* job = nextBatchJob(q);
+        if (!job) {
+            pthread_cond_wait(&q->changed, &q->lock);
+            continue;
+        }
+        job->running = true;
+        pthread_mutex_unlock(&q->lock);
+        
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool ok = runBatchStage(job, q->options);
+        job->stage_ms[job->stage] = elapsedMs(start);
+        
+        BatchStage next = job->stage + 1;
+        if (next == STAGE_WRITE && !q->options->output_dir) next = STAGE_DONE;
+        // Free the city before taking the lock; large graphs take a while
+        if (!ok || next == STAGE_DONE) {
+            if (job->result) destroyMSTResult(job->result);
+            if (job->graph) destroyCityGraph(job->graph);
+            job->result = NULL;
+            job->graph = NULL;
+        }
+        
+        pthread_mutex_lock(&q->lock);
+        job->running = false;
+        if (ok) {
+            job->stage = next;
+        } else {
+            job->failed = true;
+            q->failed++;
+        }
+        if (!ok || next == STAGE_DONE) q->in_flight--;
+        reportFinishedJobs(q);
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+// Returns the process exit status: 0 if every city succeeded
+static int runBatch(char** city_files, int city_count, const BatchOptions* options) {
+    printf("city\talgorithm\tbuildings\tlinks\ttotal_cost_millions\n");
+    fflush(stdout);
+    
+    if (city_count == 0) return 0;
+    BatchJob* jobs = (BatchJob*)calloc(city_count, sizeof(BatchJob));
+    if (!jobs) {
+        fprintf(stderr, "Memory allocation failed for batch jobs\n");
+        return 1;
+    }
+    for (int c = 0; c < city_count; c++) {
+        jobs[c].city_file = city_files[c];
+        for (int s = STAGE_LOAD; s < STAGE_DONE; s++) jobs[c].stage_ms[s] = -1.0;
+    }
+    
+    // With no thread count set, getMatrixThreadCount reports the CPUs
+    setMatrixThreadCount(0);
+    int cpus = getMatrixThreadCount();
+    
+    // More workers than cities in flight would only wait
+    int workers = options->workers > 0 ? options->workers : cpus;
+    int max_in_flight = options->max_in_flight > 0 ? options->max_in_flight : workers;
+    if (workers > max_in_flight) workers = max_in_flight;
+    if (workers > city_count) workers = city_count;
+    
+    // Workers times matrix threads stays within the CPU count unless
+    // --threads asked for more
+    int share = cpus / workers;
+    setMatrixThreadCount(options->matrix_threads > 0 ? options->matrix_threads : (share > 1 ? share : 1));
+    
+    BatchQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.jobs = jobs;
+    queue.count = city_count;
+    queue.options = options;
+    queue.max_in_flight = max_in_flight;
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.changed, NULL);
+    
+    // The cost tables are built on first use; do that before workers share them
+    getCostModel();
+    
+    pthread_t* tid = workers > 1 ? (pthread_t*)malloc((workers - 1) * sizeof(pthread_t)) : NULL;
+    int started = 0;
+    for (int w = 0; tid && w < workers - 1; w++) {
+        if (pthread_create(&tid[w], NULL, batchWorker, &queue) == 0) started++;
+    }
+    batchWorker(&queue);
+    for (int w = 0; w < started; w++) pthread_join(tid[w], NULL);
+    free(tid);
+    
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.changed);
+    free(jobs);
+    
+    if (queue.failed > 0) {
+        fprintf(stderr, "%d of %d cities failed\n", queue.failed, city_count);
+    }
+    return queue.failed > 0 ? 1 : 0;
+}
+
+static bool appendCityFile(char*** files, int* count, int* capacity, char* path) {
+    if (*count == *capacity) {
+        int grown_capacity = *capacity * 2 + 16;
+        char** grown = (char**)realloc(*files, grown_capacity * sizeof(char*));
+        if (!grown) {
+            fprintf(stderr, "Memory allocation failed for city list\n");
+            return false;
+        }
+        *files = grown;
+        *capacity = grown_capacity;
+    }
+    (*files)[(*count)++] = path;
+    return true;
+}
+
+// Appends the city files listed in a manifest, one path per line; blank
+// lines and lines starting with '#' are skipped. Returns the file contents,
+// which the appended paths point into, or NULL if it cannot be read.
+static char* readManifest(const char* filename, char*** files, int* count, int* capacity) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot open manifest: %s\n", filename);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+    if (!text || fread(text, 1, (size_t)size, file) != (size_t)size) {
+        fprintf(stderr, "Cannot read manifest: %s\n", filename);
+        free(text);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    text[size] = '\0';
+    
+    for (char* line = text; line; ) {
+        char* end = strchr(line, '\n');
+        char* next = end ? end + 1 : NULL;
+        if (!end) end = line + strlen(line);
+        while (line < end && isspace((unsigned char)*line)) line++;
+        while (end > line && isspace((unsigned char)end[-1])) end--;
+        *end = '\0';
+        
+        if (*line && *line != '#') {
+            if (!appendCityFile(files, count, capacity, line)) {
+                free(text);
+                return NULL;
+            }
+        }
+        line = next;
+    }
+    return text;
+}
+
+static void printUsage(FILE* out, const char* program) {
+    fprintf(out, "Usage: %s [options]                 interactive menus\n", program);
+    fprintf(out, "       %s [options] city.csv ...    batch mode, no prompts\n", program);
+    fprintf(out, "       %s [options] -m cities.txt   batch mode, cities listed in a manifest\n\n", program);
+    fprintf(out, "Options:\n");
+    fprintf(out, "  -t, --threads N        matrix construction threads (default: all CPUs,\n");
+    fprintf(out, "                         shared between the workers in batch mode)\n");
+    fprintf(out, "  -v, --verbose          log every building and connection\n");
+    fprintf(out, "  -q, --quiet            log nothing (default in batch mode)\n");
+    fprintf(out, "  -a, --algorithm NAME   prim (default), kruskal, boruvka or geometric\n");
+    fprintf(out, "  -s, --start N          start building for Prim (default: from the file)\n");
+    fprintf(out, "  -o, --output-dir DIR   write <city>_mst.csv for every city into DIR\n");
+    fprintf(out, "      --plan             also write <city>_plan.txt\n");
+    fprintf(out, "      --report           also write <city>_report.txt\n");
+    fprintf(out, "      --binary           also write <city>_mst.mstb (binary edge list)\n");
+    fprintf(out, "  -m, --manifest FILE    batch-process the city files listed in FILE\n");
+    fprintf(out, "  -j, --jobs N           cities processed at once (default: all CPUs)\n");
+    fprintf(out, "      --max-in-flight N  cities held in memory at once (default: --jobs)\n");
+    fprintf(out, "  -h, --help             show this help\n");
+}
+
 // ===================== MAIN FUNCTION =====================
 
-int main() {
+int main(int argc, char* argv[]) {
     CityGraph* current_city = NULL;
     MSTResult* current_result = NULL;
     int choice;
     
+    // Options are described in printUsage; any file name selects batch mode
+    BatchOptions batch = {BATCH_PRIM, -1, NULL, false, false, false, 0, 0, 0};
+    int city_capacity = argc > 1 ? argc : 1;
+    char** city_files = (char**)malloc(city_capacity * sizeof(char*));
+    int city_count = 0;
+    char* manifest = NULL;
+    bool batch_mode = false;
+    int log_level = -1;
+    if (!city_files) {
+        fprintf(stderr, "Memory allocation failed for arguments\n");
+        return 1;
+    }
+    
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if ((strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) && has_value) {
+            batch.matrix_threads = atoi(argv[++i]);
+            setMatrixThreadCount(batch.matrix_threads);
+        } else if (strcmp(argv[i], "--verbose") == 0 || strcmp(argv[i], "-v") == 0) {
+            log_level = LOG_DEBUG;
+        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
+            log_level = LOG_SILENT;
+        } else if ((strcmp(argv[i], "--algorithm") == 0 || strcmp(argv[i], "-a") == 0) && has_value) {
+            const char* name = argv[++i];
+            int a = 0;
+            while (a <= BATCH_GEOMETRIC && strcmp(name, BATCH_ALGORITHM_NAMES[a]) != 0) a++;
+            if (a > BATCH_GEOMETRIC) {
+                fprintf(stderr, "Unknown algorithm '%s'\n", name);
+                free(manifest);
+                free(city_files);
+                return 2;
+            }
+            batch.algorithm = (BatchAlgorithm)a;
+        } else if ((strcmp(argv[i], "--start") == 0 || strcmp(argv[i], "-s") == 0) && has_value) {
+            batch.start_vertex = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--output-dir") == 0 || strcmp(argv[i], "-o") == 0) && has_value) {
+            batch.output_dir = argv[++i];
+        } else if (strcmp(argv[i], "--plan") == 0) {
+            batch.write_plan = true;
+        } else if (strcmp(argv[i], "--report") == 0) {
+            batch.write_report = true;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            batch.write_binary = true;
+        } else if ((strcmp(argv[i], "--manifest") == 0 || strcmp(argv[i], "-m") == 0) && has_value) {
+            if (manifest) {
+                fprintf(stderr, "Only one manifest can be given\n");
+                free(manifest);
+                free(city_files);
+                return 2;
+            }
+            manifest = readManifest(argv[++i], &city_files, &city_count, &city_capacity);
+            if (!manifest) {
+                free(city_files);
+                return 1;
+            }
+            batch_mode = true;
+        } else if ((strcmp(argv[i], "--jobs") == 0 || strcmp(argv[i], "-j") == 0) && has_value) {
+            batch.workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-in-flight") == 0 && has_value) {
+            batch.max_in_flight = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printUsage(stdout, argv[0]);
+            free(manifest);
+            free(city_files);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown or incomplete option '%s'\n", argv[i]);
+            printUsage(stderr, argv[0]);
+            free(manifest);
+            free(city_files);
+            return 2;
+        } else {
+            if (!appendCityFile(&city_files, &city_count, &city_capacity, argv[i])) {
+                free(manifest);
+                free(city_files);
+                return 1;
+            }
+            batch_mode = true;
+        }
+    }
+    
+    // The library is silent by default; the interactive program shows
+    // progress, batch mode keeps stdout for its summary lines
+    if (batch_mode) {
+        setLogLevel(log_level >= 0 ? (LogLevel)log_level : LOG_SILENT);
+        int status = runBatch(city_files, city_count, &batch);
+        free(manifest);
+        free(city_files);
+        return status;
+    }
+    free(manifest);
+    free(city_files);
+    setLogLevel(log_level >= 0 ? (LogLevel)log_level : LOG_INFO);
+    
     printWelcomeBanner();
     
     do {
@@ -644,7 +1113,7 @@ int main() {
     
     // Cleanup
     if (current_result) {
-        free(current_result);
+        destroyMSTResult(current_result);
     }
     if (current_city) {
         destroyCityGraph(current_city);
@@ -5,14 +5,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <math.h>
 #include <time.h>
 
 // ===================== CONSTANTS =====================
-#define MAX_BUILDINGS 100
+#define MAX_BUILDINGS 100          // Default initial capacity; graphs grow past it
+#define DENSE_GRAPH_LIMIT 2000     // Largest demo city that still gets cost matrices
 #define MAX_NAME_LEN 50
 #define INF 1e9
 #define EARTH_RADIUS 6371.0  // Earth's radius in km for real GPS calculations
+#define BASE_RATE_PER_KM 2.5 // Base fiber cost in million rupees per km
+#define CACHE_LINE_SIZE 64   // Alignment of the packed cost matrices
+#define GEOMETRIC_NEIGHBORS 8 // Default k for the geometric MST candidate graph
+#define DEMO_LOCAL_LINKS 3    // Nearest-neighbour links per building in large demo cities
+#define MATRIX_TILE 256      // Rows/columns per tile when building the matrices
 
 // ===================== ENUMERATIONS =====================
 typedef enum {
@@ -32,7 +40,24 @@ typedef enum {
     FOREST = 4      // Forest area
 } TerrainType;
 
+typedef enum {
+    LOG_SILENT = 0,  // Default: the library prints nothing but errors
+    LOG_INFO = 1,    // Progress and summaries ("[INFO] ...")
+    LOG_DEBUG = 2    // Every building and connection added ("[DEBUG] ...")
+} LogLevel;
+
 // ===================== DATA STRUCTURES =====================
+#define TERRAIN_TYPE_COUNT 5
+#define BUILDING_TYPE_COUNT 6
+
+// Tariffs used by calculateAdjustedCost; see setCostModel
+typedef struct {
+    double base_rate_per_km;                          // Million rupees per km
+    double terrain_multiplier[TERRAIN_TYPE_COUNT];    // Indexed by TerrainType
+    double priority_multiplier[BUILDING_TYPE_COUNT];  // Indexed by BuildingType
+    double minimum_cost;                              // Floor for any single link
+} CostModel;
+
 typedef struct {
     int id;
     char name[MAX_NAME_LEN];
@@ -53,39 +78,185 @@ typedef struct {
 } Connection;
 
 typedef struct {
-    Building* buildings;
-    double** adj_matrix;      // Adjusted cost matrix
-    double** dist_matrix;     // Distance matrix
-    int** terrain_matrix;     // Terrain type matrix
+    Building* buildings;      // capacity entries, grows on demand
+    float* adj_matrix;        // Packed lower-triangular adjusted costs (NULL for sparse graphs)
+    float* dist_matrix;       // Packed lower-triangular distances
+    uint8_t* terrain_matrix;  // Packed lower-triangular TerrainType values
+    void* matrix_block;       // Single cache-aligned allocation behind the three triangles
+    Connection* connections;  // Explicit connections in insertion order
+    int connection_capacity;
     int vertex_count;
-    int edge_count;
+    int capacity;             // Allocated building slots (matrix dimension)
+    int edge_count;           // Number of entries in connections
     int start_vertex;        // Starting building (usually data center)
+    bool implicit_links;      // Sparse graphs: unlisted pairs are linkable too (setImplicitLinks)
     char city_name[MAX_NAME_LEN];
 } CityGraph;
 
+// ===================== PACKED MATRIX ACCESS =====================
+// Pair (i, j) with i > j lives at i*(i-1)/2 + j, so row i is contiguous and
+// adding a building only appends a row. The diagonal is not stored.
+static inline size_t pairCount(int n) {
+    return (size_t)n * (size_t)(n - 1) / 2;
+}
+
+static inline size_t pairIndex(int i, int j) {
+    if (i < j) { int t = i; i = j; j = t; }
+    return (size_t)i * (size_t)(i - 1) / 2 + (size_t)j;
+}
+
+static inline double getConnectionCost(const CityGraph* graph, int i, int j) {
+    return i == j ? INF : graph->adj_matrix[pairIndex(i, j)];
+}
+
+static inline double getConnectionDistance(const CityGraph* graph, int i, int j) {
+    return i == j ? 0.0 : graph->dist_matrix[pairIndex(i, j)];
+}
+
+static inline TerrainType getConnectionTerrain(const CityGraph* graph, int i, int j) {
+    return i == j ? PLAIN : (TerrainType)graph->terrain_matrix[pairIndex(i, j)];
+}
+
+// Arrays are sized from the vertex count by createMSTResult;
+// release with destroyMSTResult
 typedef struct {
-    int parent[MAX_BUILDINGS];
-    double key[MAX_BUILDINGS];
-    bool in_mst[MAX_BUILDINGS];
+    int* parent;
+    double* key;
+    bool* in_mst;
     double total_cost;
     int connections_used;
-    Connection mst_edges[MAX_BUILDINGS - 1];
+    int capacity;             // Vertex count the arrays were sized for
+    Connection* mst_edges;    // Up to capacity - 1 edges
 } MSTResult;
 
+// Compressed sparse row adjacency over the feasible explicit connections.
+// Each undirected connection appears once in the row of both endpoints.
+typedef struct {
+    int vertex_count;
+    int entry_count;          // 2 * number of feasible connections
+    int* row_offsets;         // vertex_count + 1 entries
+    int* neighbors;           // entry_count entries
+    double* costs;            // adjusted cost per entry
+    int* connection_ids;      // index into CityGraph.connections
+} CSRGraph;
+
+// ===================== LOGGING =====================
+LogLevel setLogLevel(LogLevel level);  // Returns the previous level
+LogLevel getLogLevel(void);
+void logMessage(LogLevel level, const char* format, ...);
+
 // ===================== GRAPH OPERATIONS =====================
 CityGraph* createCityGraph(const char* city_name, int max_vertices);
+CityGraph* createSparseCityGraph(const char* city_name, int initial_capacity);  // No matrices
 void destroyCityGraph(CityGraph* graph);
 void addBuilding(CityGraph* graph, int id, const char* name, double lat, double lon, 
                  BuildingType type, int population);
 void addConnection(CityGraph* graph, int src, int dest, TerrainType terrain, bool feasible);
+int addBuildings(CityGraph* graph, const Building* buildings, int count);       // Returns number added
+int addConnections(CityGraph* graph, const Connection* connections, int count); // Uses src/dest/terrain/feasible
 void calculateAllDistances(CityGraph* graph);
-void calculateAllCosts(CityGraph* graph);
+void calculateAllCosts(CityGraph* graph);  // Dense graphs: also prices every unlisted pair
+// Sparse graphs keep only their listed links unless this opts in to all
+// pairs (unlisted ones at plain terrain, as calculateAllCosts prices them
+// on dense graphs); loadCityFromCSV opts in, generateDemoCity does not.
+// Sparse all-pairs cities work with primMST, kruskalMST, boruvkaMST,
+// primMSTGeometric, runScenarios and the baselines; buildCSRGraph and
+// primMSTSparse see the listed links only, and createDynamicMST refuses them.
+void setImplicitLinks(CityGraph* graph, bool enabled);
+int setMatrixThreadCount(int threads);  // 0 = one per CPU (default); returns previous
+int getMatrixThreadCount(void);         // Threads the matrix builders will use
 
 // ===================== PRIM'S ALGORITHM CORE =====================
-MSTResult* primMST(CityGraph* graph, int start_vertex);
+MSTResult* createMSTResult(int vertex_count);
+void destroyMSTResult(MSTResult* result);
+MSTResult* primMST(CityGraph* graph, int start_vertex);  // Sparse all-pairs cities: primMSTGeometric
 void primMSTStepByStep(CityGraph* graph, int start_vertex);
 int findMinKeyVertex(double key[], bool in_mst[], int n);
 
+// ===================== SPARSE GRAPH & HEAP-BASED PRIM =====================
+CSRGraph* buildCSRGraph(CityGraph* graph);
+void destroyCSRGraph(CSRGraph* csr);
+MSTResult* primMSTSparse(CityGraph* graph, CSRGraph* csr, int start_vertex);  // O(E log V), listed links only
+
+// ===================== GEOMETRIC MST =====================
+// Exact MST of the implicit all-pairs city (explicit costs where set, plain
+// terrain elsewhere, as calculateAllCosts prices it) from k-nearest-neighbour
+// candidates; needs no matrices and no calculateAllCosts. neighbors <= 0
+// uses GEOMETRIC_NEIGHBORS.
+MSTResult* primMSTGeometric(CityGraph* graph, int start_vertex, int neighbors);
+
+// ===================== SPATIAL INDEX =====================
+// Uniform grid over the buildings of a graph for nearest-neighbour and
+// radius queries without scanning every building. It refers to the graph's
+// building array: rebuild it after buildings are added or moved.
+#define ANY_BUILDING_TYPE -1
+typedef struct SpatialIndex SpatialIndex;
+
+SpatialIndex* createSpatialIndex(const CityGraph* graph);
+void destroySpatialIndex(SpatialIndex* index);
+// Up to k buildings of `type` (or ANY_BUILDING_TYPE) nearest to the point,
+// nearest first; returns how many were found. distances_km may be NULL.
+int findNearestBuildings(const SpatialIndex* index, double lat, double lon, int k, int type,
+                         int* ids, double* distances_km);
+// Buildings within radius_km, in no particular order; stores at most
+// max_results and returns the total number of matches
+int findBuildingsWithin(const SpatialIndex* index, double lat, double lon, double radius_km, int type,
+                        int* ids, double* distances_km, int max_results);
+
+// ===================== DYNAMIC MST =====================
+// Minimum spanning forest kept current while connections are added,
+// repriced or toggled, without rerunning Prim. Covers the buildings present
+// at creation; costs follow the graph as it is then (call calculateAllCosts
+// first on dense cities) and updates are written through to the graph.
+// Sparse cities must be cities of listed links (no setImplicitLinks).
+typedef struct DynamicMST DynamicMST;
+
+// One tree edge touched by an update: old_cost == INF if it joined the
+// tree, new_cost == INF if it left, both set if it was repriced
+typedef struct {
+    int src_id;
+    int dest_id;
+    double old_cost;
+    double new_cost;
+} MSTEdgeChange;
+
+DynamicMST* createDynamicMST(CityGraph* graph);
+void destroyDynamicMST(DynamicMST* dyn);
+bool updateDynamicConnection(DynamicMST* dyn, int src, int dest, TerrainType terrain, bool feasible);
+double getDynamicMSTCost(const DynamicMST* dyn);
+int getDynamicMSTEdgeCount(const DynamicMST* dyn);
+int getDynamicMSTChanges(const DynamicMST* dyn, const MSTEdgeChange** changes);  // Of the last update
+MSTResult* snapshotDynamicMST(DynamicMST* dyn);
+
+// ===================== WHAT-IF SCENARIOS =====================
+// Evaluates many tariff scenarios on one city in parallel. Each scenario has
+// its own cost model and a list of overridden links (src_id, dest_id,
+// terrain, is_feasible; other fields are ignored): an infeasible override
+// blocks the link, a feasible one sets its terrain. The city itself is not
+// modified. Dense cities need calculateAllDistances first; sparse all-pairs
+// cities (setImplicitLinks) are solved over geometric candidates found under
+// each scenario's tariffs, so their trees are exact too.
+typedef struct {
+    char name[MAX_NAME_LEN];
+    CostModel model;
+    const Connection* overrides;
+    int override_count;
+} Scenario;
+
+// Tree of one scenario, compared with the tree under the current tariffs
+typedef struct {
+    MSTResult* mst;             // NULL if the scenario could not be evaluated
+    double cost_change;
+    int edges_added;            // Tree links not in the current tree
+    int edges_removed;          // Current tree links no longer used
+} ScenarioResult;
+
+// threads <= 0 uses getMatrixThreadCount(); release with destroyScenarioResults
+ScenarioResult* runScenarios(CityGraph* graph, const Scenario* scenarios, int count, int threads);
+void destroyScenarioResults(ScenarioResult* results, int count);
+void printScenarioComparison(CityGraph* graph, const Scenario* scenarios, const ScenarioResult* results,
+                             int count);
+
 // ===================== VISUALIZATION FUNCTIONS =====================
 void printBuildingInfo(Building b);
 void printConnectionInfo(CityGraph* graph, int src, int dest);
@@ -102,10 +273,18 @@ const char* getBuildingTypeName(BuildingType type);
 const char* getTerrainTypeName(TerrainType terrain);
 double getTerrainMultiplier(TerrainType terrain);
 double getPriorityMultiplier(BuildingType type);
+CostModel getDefaultCostModel(void);
+CostModel getCostModel(void);
+void setCostModel(const CostModel* model);  // NULL restores the defaults; then call repriceCity
+void repriceCity(CityGraph* graph);         // Re-applies the active tariffs to every link
+const char* getDistanceKernelName(void);  // "avx512", "avx2" or "scalar" (calculateAllDistances)
 
 // ===================== FILE I/O OPERATIONS =====================
-CityGraph* loadCityFromCSV(const char* filename);
+CityGraph* loadCityFromCSV(const char* filename);      // Reuses/refreshes <name>.cityb
+CityGraph* loadCityFromBinary(const char* filename);   // .cityb cache, one read
+bool saveCityToBinary(CityGraph* graph, const char* filename);
 void saveMSTToCSV(CityGraph* graph, MSTResult* result, const char* filename);
+bool saveMSTToBinary(CityGraph* graph, MSTResult* result, const char* filename);  // .mstb edge list
 void saveNetworkPlan(CityGraph* graph, MSTResult* result, const char* filename);
 void generateReport(CityGraph* graph, MSTResult* result, const char* filename);
 
@@ -116,7 +295,8 @@ void calculateStatistics(CityGraph* graph, MSTResult* result);
 void animateMSTConstruction(CityGraph* graph, MSTResult* result, int delay_ms);
 
 // ===================== ALGORITHM COMPARISON =====================
-MSTResult* kruskalMST(CityGraph* graph);  // For comparison
+MSTResult* kruskalMST(CityGraph* graph);   // Radix-sorted edges + union-find
+MSTResult* boruvkaMST(CityGraph* graph);   // Multi-threaded (setMatrixThreadCount)
 double calculateNaiveNetworkCost(CityGraph* graph);  // Random connections cost
 double calculateStarNetworkCost(CityGraph* graph);   // All connect to center
 
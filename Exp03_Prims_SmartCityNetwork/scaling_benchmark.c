@@ -0,0 +1,196 @@
+#include "prims.h"
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// End-to-end scaling benchmark.
+// Generates demo cities of 10^2 ... max buildings (dense up to
+// DENSE_GRAPH_LIMIT, sparse beyond) and times each phase separately with
+// the monotonic clock:
+//   load       generateDemoCity (records, batch ingestion, first matrix build)
+//   distances  calculateAllDistances
+//   costs      repriceCity (every implicit and explicit link repriced)
+//   mst        primMST (heap-based Prim for sparse cities)
+//   report     saveMSTToCSV + generateReport
+// plus the peak resident set size of each run. Results are written as JSON
+// so they can be compared between commits.
+//
+// Usage: prims_scaling [max_buildings] [output.json]
+
+#define SCALING_PHASES 5
+static const char* PHASE_NAMES[SCALING_PHASES] = {"load", "distances", "costs", "mst", "report"};
+
+typedef struct {
+    int buildings;
+    bool dense;
+    int connections;
+    int mst_edges;
+    double total_cost;
+    double phase_ms[SCALING_PHASES];
+    long peak_rss_kb;           // -1 when the platform does not report it
+} ScalingRun;
+
+static double millisecondsSince(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1000.0 + (now.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+// Linux can reset the peak RSS (VmHWM) between runs; elsewhere the process
+// peak only grows, which still bounds each run since sizes increase
+static void resetPeakResident(void) {
+#ifdef __linux__
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (f) {
+        fputs("5", f);
+        fclose(f);
+    }
+#endif
+}
+
+static long peakResidentKB(void) {
+#ifdef __linux__
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+        }
+        fclose(f);
+        if (kb >= 0) return kb;
+    }
+#endif
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static bool runScaling(int building_count, ScalingRun* run) {
+    memset(run, 0, sizeof(*run));
+    run->buildings = building_count;
+    resetPeakResident();
+
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    CityGraph* graph = generateDemoCity(building_count);
+    if (!graph) return false;
+    run->phase_ms[0] = millisecondsSince(t);
+    run->dense = graph->adj_matrix != NULL;
+    run->connections = graph->edge_count;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    calculateAllDistances(graph);
+    run->phase_ms[1] = millisecondsSince(t);
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    repriceCity(graph);
+    run->phase_ms[2] = millisecondsSince(t);
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    MSTResult* result = primMST(graph, graph->start_vertex);
+    run->phase_ms[3] = millisecondsSince(t);
+    if (!result) {
+        destroyCityGraph(graph);
+        return false;
+    }
+    run->mst_edges = result->connections_used;
+    run->total_cost = result->total_cost;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    saveMSTToCSV(graph, result, "scaling_mst.tmp");
+    generateReport(graph, result, "scaling_report.tmp");
+    run->phase_ms[4] = millisecondsSince(t);
+    remove("scaling_mst.tmp");
+    remove("scaling_report.tmp");
+
+    run->peak_rss_kb = peakResidentKB();
+    destroyMSTResult(result);
+    destroyCityGraph(graph);
+    return true;
+}
+
+static bool writeScalingJSON(const char* filename, const ScalingRun* runs, int count) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot create file: %s\n", filename);
+        return false;
+    }
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"benchmark\": \"prim_scaling\",\n");
+    fprintf(file, "  \"timestamp\": \"%s\",\n", stamp);
+    fprintf(file, "  \"threads\": %d,\n", getMatrixThreadCount());
+    fprintf(file, "  \"distance_kernel\": \"%s\",\n", getDistanceKernelName());
+    fprintf(file, "  \"dense_graph_limit\": %d,\n", DENSE_GRAPH_LIMIT);
+    fprintf(file, "  \"runs\": [\n");
+    for (int r = 0; r < count; r++) {
+        const ScalingRun* run = &runs[r];
+        fprintf(file, "    {\n");
+        fprintf(file, "      \"buildings\": %d,\n", run->buildings);
+        fprintf(file, "      \"graph\": \"%s\",\n", run->dense ? "dense" : "sparse");
+        fprintf(file, "      \"connections\": %d,\n", run->connections);
+        fprintf(file, "      \"mst_edges\": %d,\n", run->mst_edges);
+        fprintf(file, "      \"total_cost_millions\": %.4f,\n", run->total_cost);
+        fprintf(file, "      \"phases_ms\": {");
+        for (int p = 0; p < SCALING_PHASES; p++) {
+            fprintf(file, "%s\"%s\": %.3f", p ? ", " : "", PHASE_NAMES[p], run->phase_ms[p]);
+        }
+        fprintf(file, "},\n");
+        fprintf(file, "      \"peak_rss_kb\": %ld\n", run->peak_rss_kb);
+        fprintf(file, "    }%s\n", r + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    bool ok = fclose(file) == 0;
+    if (!ok) fprintf(stderr, "Failed to write %s\n", filename);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int max_buildings = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char* output = argc > 2 ? argv[2] : "scaling_results.json";
+    if (max_buildings < 100) max_buildings = 100;
+
+    ScalingRun runs[16];
+    int count = 0;
+
+    printf("\nPrim scaling: 10^2 to %d buildings, %d thread%s, %s distance kernel\n",
+           max_buildings, getMatrixThreadCount(), getMatrixThreadCount() == 1 ? "" : "s",
+           getDistanceKernelName());
+    printf("┌───────────┬────────┬───────────┬───────────┬───────────┬───────────┬───────────┬────────────┐\n");
+    printf("│ Buildings │ Graph  │ Load (ms) │ Dist (ms) │ Cost (ms) │ MST (ms)  │ Rept (ms) │ Peak (MB)  │\n");
+    printf("├───────────┼────────┼───────────┼───────────┼───────────┼───────────┼───────────┼────────────┤\n");
+
+    for (long long n = 100; n <= max_buildings && count < 16; n *= 10) {
+        ScalingRun* run = &runs[count];
+        if (!runScaling((int)n, run)) {
+            fprintf(stderr, "Run with %lld buildings failed\n", n);
+            break;
+        }
+        count++;
+        printf("│ %9d │ %-6s │ %9.2f │ %9.2f │ %9.2f │ %9.2f │ %9.2f │ %10.1f │\n",
+               run->buildings, run->dense ? "dense" : "sparse", run->phase_ms[0], run->phase_ms[1],
+               run->phase_ms[2], run->phase_ms[3], run->phase_ms[4],
+               run->peak_rss_kb >= 0 ? run->peak_rss_kb / 1024.0 : -1.0);
+        fflush(stdout);
+    }
+    printf("└───────────┴────────┴───────────┴───────────┴───────────┴───────────┴───────────┴────────────┘\n");
+
+    if (count == 0 || !writeScalingJSON(output, runs, count)) return 1;
+    printf("Results written to %s\n", output);
+    return 0;
+}
@@ -1,4 +1,142 @@
 #include "prims.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define SCENARIO_CITY_SIZE 400
+#define DYNAMIC_TEST_CITIES 40
+#define DYNAMIC_TEST_UPDATES 300
+
+// Sparse all-pairs city with a few listed links, some infeasible; the
+// extra link, if any, is laid on URBAN terrain as a scenario override would
+static CityGraph* buildScenarioCity(const Connection* extra) {
+    CityGraph* city = createSparseCityGraph("Scenario City", SCENARIO_CITY_SIZE);
+    srand(7);
+    for (int i = 0; i < SCENARIO_CITY_SIZE; i++) {
+        double lat = 18.4 + (rand() % 10000) / 50000.0;
+        double lon = 73.7 + (rand() % 10000) / 50000.0;
+        addBuilding(city, i, "B", lat, lon, (BuildingType)(rand() % 6), rand() % 3000);
+    }
+    for (int e = 0; e < SCENARIO_CITY_SIZE / 2; e++) {
+        int a = rand() % SCENARIO_CITY_SIZE, b = rand() % SCENARIO_CITY_SIZE;
+        if (a != b) addConnection(city, a, b, (TerrainType)(rand() % 5), rand() % 4 != 0);
+    }
+    if (extra) addConnection(city, extra->src_id, extra->dest_id, extra->terrain, true);
+    setImplicitLinks(city, true);
+    return city;
+}
+
+// runScenarios on a sparse all-pairs city must match switching the tariffs,
+// repricing the city and solving it from scratch
+static int testScenarioTotals(void) {
+    Connection override = {.src_id = 3, .dest_id = 250, .terrain = URBAN, .is_feasible = true};
+    Scenario scenarios[4];
+    for (int s = 0; s < 4; s++) {
+        scenarios[s].model = getDefaultCostModel();
+        scenarios[s].overrides = NULL;
+        scenarios[s].override_count = 0;
+    }
+    snprintf(scenarios[0].name, MAX_NAME_LEN, "Current");
+    snprintf(scenarios[1].name, MAX_NAME_LEN, "Cheap schools");
+    scenarios[1].model.priority_multiplier[SCHOOL] = 0.2;
+    snprintf(scenarios[2].name, MAX_NAME_LEN, "Cheap urban");
+    scenarios[2].model.terrain_multiplier[URBAN] = 0.3;
+    scenarios[2].model.minimum_cost = 0.1;
+    snprintf(scenarios[3].name, MAX_NAME_LEN, "Urban link");
+    scenarios[3].model.terrain_multiplier[URBAN] = 0.3;
+    scenarios[3].overrides = &override;
+    scenarios[3].override_count = 1;
+    
+    CityGraph* city = buildScenarioCity(NULL);
+    ScenarioResult* results = runScenarios(city, scenarios, 4, 2);
+    int failures = results ? 0 : 1;
+    for (int s = 0; results && s < 4; s++) {
+        CityGraph* fresh = buildScenarioCity(scenarios[s].override_count ? &override : NULL);
+        setCostModel(&scenarios[s].model);
+        repriceCity(fresh);
+        MSTResult* expected = primMST(fresh, 0);
+        if (!results[s].mst || !expected ||
+            fabs(results[s].mst->total_cost - expected->total_cost) > 1e-6 * expected->total_cost) {
+            printf("FAIL scenario '%s': %.6f, fresh MST %.6f\n", scenarios[s].name,
+                   results[s].mst ? results[s].mst->total_cost : -1.0,
+                   expected ? expected->total_cost : -1.0);
+            failures++;
+        }
+        destroyMSTResult(expected);
+        destroyCityGraph(fresh);
+        setCostModel(NULL);
+    }
+    destroyScenarioResults(results, 4);
+    destroyCityGraph(city);
+    printf("Scenario totals on a sparse all-pairs city: %s\n", failures ? "FAILED" : "ok");
+    return failures;
+}
+
+// Random city for the dynamic MST check: dense cities price every pair,
+// sparse ones list a few random links
+static CityGraph* buildDynamicCity(int n, bool dense) {
+    CityGraph* city = dense ? createCityGraph("Dynamic City", n) : createSparseCityGraph("Dynamic City", n);
+    for (int i = 0; i < n; i++) {
+        double lat = 18.4 + (rand() % 10000) / 50000.0;
+        double lon = 73.7 + (rand() % 10000) / 50000.0;
+        addBuilding(city, i, "B", lat, lon, (BuildingType)(rand() % 6), rand() % 3000);
+    }
+    if (dense) {
+        calculateAllDistances(city);
+        calculateAllCosts(city);
+    } else {
+        for (int a = 0; a < n; a++) {
+            for (int b = a + 1; b < n; b++) {
+                if (rand() % 4 == 0) addConnection(city, a, b, (TerrainType)(rand() % 5), rand() % 4 != 0);
+            }
+        }
+    }
+    return city;
+}
+
+// After every update the dynamic forest must cost what a fresh Kruskal
+// forest of the updated city costs. Half the updates hit tree edges.
+static int testDynamicUpdates(void) {
+    int failures = 0;
+    srand(11);
+    for (int k = 0; k < DYNAMIC_TEST_CITIES && !failures; k++) {
+        int n = 8 + rand() % 120;
+        CityGraph* city = buildDynamicCity(n, k % 2 == 0);
+        DynamicMST* dyn = createDynamicMST(city);
+        if (!dyn) {
+            destroyCityGraph(city);
+            failures++;
+            break;
+        }
+        for (int u = 0; u < DYNAMIC_TEST_UPDATES && !failures; u++) {
+            int a = rand() % n, b = rand() % n;
+            if (rand() % 2 == 0) {
+                MSTResult* tree = snapshotDynamicMST(dyn);
+                if (tree && tree->connections_used > 0) {
+                    const Connection* edge = &tree->mst_edges[rand() % tree->connections_used];
+                    a = edge->src_id;
+                    b = edge->dest_id;
+                }
+                destroyMSTResult(tree);
+            }
+            if (a == b) continue;
+            
+            updateDynamicConnection(dyn, a, b, (TerrainType)(rand() % 5), rand() % 4 != 0);
+            MSTResult* fresh = kruskalMST(city);
+            if (!fresh || fabs(getDynamicMSTCost(dyn) - fresh->total_cost) > 1e-6 * (1.0 + fresh->total_cost) ||
+                getDynamicMSTEdgeCount(dyn) != fresh->connections_used) {
+                printf("FAIL city %d update %d: dynamic %.6f (%d edges), fresh %.6f (%d edges)\n", k, u,
+                       getDynamicMSTCost(dyn), getDynamicMSTEdgeCount(dyn),
+                       fresh ? fresh->total_cost : -1.0, fresh ? fresh->connections_used : -1);
+                failures++;
+            }
+            destroyMSTResult(fresh);
+        }
+        destroyDynamicMST(dyn);
+        destroyCityGraph(city);
+    }
+    printf("Dynamic MST against fresh forests: %s\n", failures ? "FAILED" : "ok");
+    return failures;
+}
 
 int main() {
     // Create a simple test city
@@ -24,8 +162,14 @@ int main() {
     printMSTResult(city, result);
     
     // Cleanup
-    free(result);
+    destroyMSTResult(result);
     destroyCityGraph(city);
     
-    return 0;
-}
\ No newline at end of file
+    int failures = 0;
+    LogLevel previous = setLogLevel(LOG_SILENT);
+    failures += testScenarioTotals();
+    failures += testDynamicUpdates();
+    setLogLevel(previous);
+    
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "kruskal.h"
+
+// Parallel connected-components benchmark.
+// Builds a random graph of V vertices and E edges (default 10^7 and 10^8),
+// finds its components once with the sequential DisjointSet and then with
+// parallelComponents on 1, 2, 4, ... threads up to all CPUs, checking that
+// every run finds exactly the same components.
+//
+// Usage: components_benchmark [vertices] [edges] [max_threads]
+
+static double elapsedSeconds(struct timespec start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static Edge *buildRandomGraph(int V, size_t E)
+{
+    Edge *edges = malloc(E * sizeof(Edge));
+    if (edges == NULL)
+        return NULL;
+
+    uint64_t state = 88172645463325252ull;
+    for (size_t i = 0; i < E; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        edges[i].src = (int)((state & 0xFFFFFFFFu) % (uint32_t)V);
+        edges[i].dest = (int)((state >> 32) % (uint32_t)V);
+        edges[i].weight = 1;
+    }
+    return edges;
+}
+
+// Same partition as the sequential run: the counts match and no edge
+// joins two different labels
+static bool sameComponents(const Edge edges[], size_t E, const uint32_t labels[],
+                           long long components, long long expected)
+{
+    if (components != expected)
+        return false;
+    for (size_t i = 0; i < E; i++)
+    {
+        if (labels[edges[i].src] != labels[edges[i].dest])
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int V = argc > 1 ? atoi(argv[1]) : 10000000;
+    size_t E = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10) : 100000000;
+    int maxThreads = argc > 3 ? atoi(argv[3]) : getCpuCount();
+    if (V < 2)
+        V = 2;
+    if (maxThreads < 1)
+        maxThreads = 1;
+
+    Edge *edges = buildRandomGraph(V, E);
+    uint32_t *labels = malloc((size_t)V * sizeof(uint32_t));
+    DisjointSet *set = makeDisjointSet((uint32_t)V);
+    if (edges == NULL || labels == NULL || set == NULL)
+    {
+        fprintf(stderr, "Not enough memory for %d vertices and %zu edges\n", V, E);
+        return 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < E; i++)
+    {
+        unionSet(set, (uint32_t)edges[i].src, (uint32_t)edges[i].dest);
+    }
+    long long expected = componentCount(set);
+    double sequentialTime = elapsedSeconds(start);
+    freeDisjointSet(set);
+
+    printf("\nConnected components: %d vertices, %zu edges, %lld components\n", V, E, expected);
+    printf("┌──────────────┬────────────┬──────────────┬────────────┐\n");
+    printf("│ Threads      │ Time (s)   │ Edges/s (M)  │ Speedup    │\n");
+    printf("├──────────────┼────────────┼──────────────┼────────────┤\n");
+    printf("│ %-12s │ %10.3f │ %12.1f │ %9.2fx │\n", "sequential", sequentialTime,
+           E / sequentialTime / 1e6, 1.0);
+    fflush(stdout);
+
+    for (int threads = 1; ; threads *= 2)
+    {
+        if (threads > maxThreads)
+            threads = maxThreads;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        long long components = parallelComponents(V, E, edges, threads, labels);
+        double time = elapsedSeconds(start);
+
+        if (!sameComponents(edges, E, labels, components, expected))
+        {
+            printf("│ %12d │ wrong components: %lld\n", threads, components);
+            return 1;
+        }
+        printf("│ %12d │ %10.3f │ %12.1f │ %9.2fx │\n", threads, time, E / time / 1e6,
+               sequentialTime / time);
+        fflush(stdout);
+        if (threads >= maxThreads)
+            break;
+    }
+    printf("└──────────────┴────────────┴──────────────┴────────────┘\n");
+
+    free(edges);
+    free(labels);
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "kruskal.h"
+
+#ifdef _WIN32
+#include <windows.h>    // GetSystemInfo
+#else
+#include <unistd.h>     // sysconf
+#endif
+
+// Concurrent Disjoint Set (Jayanti–Tarjan style)
+// All threads share one parent array and change it only with
+// compare-and-swap, so no thread ever waits for another:
+//   find:  path halving; a vertex is moved to its grandparent with one CAS
+//          attempt, and a failed CAS is simply ignored.
+//   union: the root with the lower random priority is linked under the
+//          other with a CAS that succeeds only if it is still a root;
+//          otherwise both roots are looked up again.
+// Priorities come from a fixed hash of the vertex number, so linking is
+// randomized without storing anything per vertex. Links always go towards
+// higher priority, so no cycle can form and trees stay shallow.
+
+ConcurrentDisjointSet *makeConcurrentDisjointSet(uint32_t n)
+{
+    ConcurrentDisjointSet *set = malloc(sizeof(ConcurrentDisjointSet));
+    if (set == NULL)
+        return NULL;
+
+    set->parent = malloc((n > 0 ? n : 1) * sizeof(_Atomic uint32_t));
+    if (set->parent == NULL)
+    {
+        free(set);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        atomic_init(&set->parent[i], i);
+    }
+    set->size = n;
+    return set;
+}
+
+void freeConcurrentDisjointSet(ConcurrentDisjointSet *set)
+{
+    if (set == NULL)
+        return;
+    free((void *)set->parent);
+    free(set);
+}
+
+// Random but fixed priority; the vertex number breaks ties
+static inline uint64_t linkPriority(uint32_t v)
+{
+    uint32_t h = v * 0x9E3779B1u;
+    h ^= h >> 15;
+    h *= 0x85EBCA77u;
+    h ^= h >> 13;
+    return ((uint64_t)h << 32) | v;
+}
+
+uint32_t concurrentFind(ConcurrentDisjointSet *set, uint32_t v)
+{
+    _Atomic uint32_t *parent = set->parent;
+    for (;;)
+    {
+        uint32_t p = atomic_load_explicit(&parent[v], memory_order_acquire);
+        if (p == v)
+            return v;
+        uint32_t grandparent = atomic_load_explicit(&parent[p], memory_order_acquire);
+        if (grandparent != p)
+        {
+            atomic_compare_exchange_weak_explicit(&parent[v], &p, grandparent,
+                                                  memory_order_release, memory_order_relaxed);
+        }
+        v = grandparent;
+    }
+}
+
+bool concurrentUnion(ConcurrentDisjointSet *set, uint32_t a, uint32_t b)
+{
+    for (;;)
+    {
+        a = concurrentFind(set, a);
+        b = concurrentFind(set, b);
+        if (a == b)
+            return false;
+
+        if (linkPriority(a) > linkPriority(b))
+        {
+            uint32_t temp = a;
+            a = b;
+            b = temp;
+        }
+        uint32_t expected = a;
+        if (atomic_compare_exchange_strong_explicit(&set->parent[a], &expected, b,
+                                                    memory_order_acq_rel, memory_order_acquire))
+            return true;
+    }
+}
+
+bool concurrentSameSet(ConcurrentDisjointSet *set, uint32_t a, uint32_t b)
+{
+    for (;;)
+    {
+        a = concurrentFind(set, a);
+        b = concurrentFind(set, b);
+        if (a == b)
+            return true;
+        // a was a root when b was found, so they were apart at that moment
+        if (atomic_load_explicit(&set->parent[a], memory_order_acquire) == a)
+            return false;
+    }
+}
+
+int getCpuCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (int)online : 1;
+#endif
+}
+
+// ---------------- Parallel connected components ----------------
+// Every thread unites the endpoints of its own contiguous slice of the
+// edge list. After all threads have joined, each thread labels a slice of
+// the vertices with their root and counts the roots in it.
+
+typedef struct
+{
+    ConcurrentDisjointSet *set;
+    const Edge *edges;
+    size_t firstEdge, lastEdge;
+    uint32_t firstVertex, lastVertex;
+    uint32_t *labels;         // NULL = only count
+    uint32_t roots;
+} ComponentsJob;
+
+static void *uniteEdges(void *arg)
+{
+    ComponentsJob *job = (ComponentsJob *)arg;
+    uint32_t n = job->set->size;
+    for (size_t i = job->firstEdge; i < job->lastEdge; i++)
+    {
+        uint32_t u = (uint32_t)job->edges[i].src;
+        uint32_t v = (uint32_t)job->edges[i].dest;
+        if (u < n && v < n)    // Negative ids wrap around and are skipped too
+            concurrentUnion(job->set, u, v);
+    }
+    return NULL;
+}
+
+static void *labelVertices(void *arg)
+{
+    ComponentsJob *job = (ComponentsJob *)arg;
+    job->roots = 0;
+    for (uint32_t v = job->firstVertex; v < job->lastVertex; v++)
+    {
+        uint32_t root = concurrentFind(job->set, v);
+        if (root == v)
+            job->roots++;
+        if (job->labels)
+            job->labels[v] = root;
+    }
+    return NULL;
+}
+
+// Runs fn on every job, job 0 on the calling thread
+static void runJobs(ComponentsJob jobs[], int threads, void *(*fn)(void *))
+{
+    pthread_t tid[threads];
+    bool started[threads];
+    for (int t = 1; t < threads; t++)
+    {
+        started[t] = pthread_create(&tid[t], NULL, fn, &jobs[t]) == 0;
+        if (!started[t])
+            fn(&jobs[t]);
+    }
+    fn(&jobs[0]);
+    for (int t = 1; t < threads; t++)
+    {
+        if (started[t])
+            pthread_join(tid[t], NULL);
+    }
+}
+
+long long parallelComponents(int V, size_t E, const Edge edges[], int threads, uint32_t labels[])
+{
+    if (V <= 0)
+        return 0;
+    if (threads <= 0)
+        threads = getCpuCount();
+
+    ConcurrentDisjointSet *set = makeConcurrentDisjointSet((uint32_t)V);
+    ComponentsJob *jobs = malloc((size_t)threads * sizeof(ComponentsJob));
+    if (set == NULL || jobs == NULL)
+    {
+        freeConcurrentDisjointSet(set);
+        free(jobs);
+        return -1;
+    }
+
+    for (int t = 0; t < threads; t++)
+    {
+        jobs[t].set = set;
+        jobs[t].edges = edges;
+        jobs[t].firstEdge = E * t / threads;
+        jobs[t].lastEdge = E * (t + 1) / threads;
+        jobs[t].firstVertex = (uint32_t)((uint64_t)V * t / threads);
+        jobs[t].lastVertex = (uint32_t)((uint64_t)V * (t + 1) / threads);
+        jobs[t].labels = labels;
+    }
+    runJobs(jobs, threads, uniteEdges);
+    runJobs(jobs, threads, labelVertices);
+
+    long long components = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        components += jobs[t].roots;
+    }
+    free(jobs);
+    freeConcurrentDisjointSet(set);
+    return components;
+}
@@ -1,101 +1,546 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "kruskal.h"
 
-#define MAX_VERTICES 100
+#ifdef _WIN32
+#include <windows.h>    // File mapping
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-// Disjoint Set (Union-Find) parent array
-int parent[MAX_VERTICES];
+// Radix sort digit: 8 bits, so a 32-bit weight takes at most 4 passes
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
 
-// Initialize each vertex as its own parent
-void makeSet(int V)
+// Create n singleton sets, one per vertex
+DisjointSet *makeDisjointSet(uint32_t n)
 {
-    for (int i = 0; i < V; i++)
+    DisjointSet *set = malloc(sizeof(DisjointSet));
+    if (set == NULL)
+        return NULL;
+
+    set->parent = malloc((n > 0 ? n : 1) * sizeof(uint32_t));
+    set->rank = calloc(n > 0 ? n : 1, sizeof(uint8_t));
+    if (set->parent == NULL || set->rank == NULL)
+    {
+        free(set->parent);
+        free(set->rank);
+        free(set);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < n; i++)
     {
-        parent[i] = i;
+        set->parent[i] = i;
     }
+    set->size = n;
+    set->components = n;
+    return set;
+}
+
+void freeDisjointSet(DisjointSet *set)
+{
+    if (set == NULL)
+        return;
+    free(set->parent);
+    free(set->rank);
+    free(set);
 }
 
-// Find with simple path compression
-int findSet(int v)
+// Find with path halving: every visited vertex is pointed at its
+// grandparent, which flattens the tree without recursion
+uint32_t findSet(DisjointSet *set, uint32_t v)
 {
-    if (parent[v] == v)
-        return v;
-    parent[v] = findSet(parent[v]);  // path compression
-    return parent[v];
+    uint32_t *parent = set->parent;
+    while (parent[v] != v)
+    {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
 }
 
-// Union of two sets
-void unionSet(int a, int b)
+// Union by rank: the shorter tree goes under the taller one.
+// Returns false if a and b were already in the same set.
+bool unionSet(DisjointSet *set, uint32_t a, uint32_t b)
 {
-    a = findSet(a);
-    b = findSet(b);
-    if (a != b)
+    a = findSet(set, a);
+    b = findSet(set, b);
+    if (a == b)
+        return false;
+
+    if (set->rank[a] < set->rank[b])
+    {
+        uint32_t temp = a;
+        a = b;
+        b = temp;
+    }
+    set->parent[b] = a;
+    if (set->rank[a] == set->rank[b])
     {
-        parent[b] = a;
+        set->rank[a]++;
     }
+    set->components--;
+    return true;
+}
+
+bool sameSet(DisjointSet *set, uint32_t a, uint32_t b)
+{
+    return findSet(set, a) == findSet(set, b);
+}
+
+uint32_t componentCount(const DisjointSet *set)
+{
+    return set->components;
 }
 
-// Simple bubble sort by weight
-void sortEdgesByWeight(Edge edges[], int E)
+// LSD radix sort by weight, RADIX_BITS per pass. Each weight is turned
+// into an unsigned key (sign bit flipped, so negative costs sort first)
+// and carried together with its edge index; the edges are moved only
+// once at the end. Passes in which every key has the same digit are
+// skipped. The sort is stable, so equal weights keep their input order.
+// Needs EDGE_SORT_SCRATCH bytes per edge; returns false (edges untouched)
+// if they cannot be allocated.
+bool sortEdgesByWeight(Edge edges[], int E)
 {
-    for (int i = 0; i < E - 1; i++)
+    if (E < 2)
+        return true;
+
+    unsigned int *keys = malloc(2 * (size_t)E * sizeof(unsigned int));
+    int *order = malloc(2 * (size_t)E * sizeof(int));
+    Edge *sorted = malloc((size_t)E * sizeof(Edge));
+    if (keys == NULL || order == NULL || sorted == NULL)
+    {
+        free(keys);
+        free(order);
+        free(sorted);
+        return false;
+    }
+
+    unsigned int *keysIn = keys, *keysOut = keys + E;
+    int *orderIn = order, *orderOut = order + E;
+    for (int i = 0; i < E; i++)
+    {
+        keysIn[i] = (unsigned int)edges[i].weight ^ 0x80000000u;
+        orderIn[i] = i;
+    }
+
+    for (int shift = 0; shift < 32; shift += RADIX_BITS)
     {
-        for (int j = 0; j < E - 1 - i; j++)
+        int count[RADIX_BUCKETS] = {0};
+        for (int i = 0; i < E; i++)
         {
-            if (edges[j].weight > edges[j + 1].weight)
-            {
-                Edge temp = edges[j];
-                edges[j] = edges[j + 1];
-                edges[j + 1] = temp;
-            }
+            count[(keysIn[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+        }
+        if (count[(keysIn[0] >> shift) & (RADIX_BUCKETS - 1)] == E)
+            continue;
+
+        int position = 0;
+        for (int d = 0; d < RADIX_BUCKETS; d++)
+        {
+            int bucketSize = count[d];
+            count[d] = position;
+            position += bucketSize;
+        }
+        for (int i = 0; i < E; i++)
+        {
+            int d = (keysIn[i] >> shift) & (RADIX_BUCKETS - 1);
+            keysOut[count[d]] = keysIn[i];
+            orderOut[count[d]++] = orderIn[i];
         }
+
+        unsigned int *keysTemp = keysIn;
+        keysIn = keysOut;
+        keysOut = keysTemp;
+        int *orderTemp = orderIn;
+        orderIn = orderOut;
+        orderOut = orderTemp;
+    }
+
+    for (int i = 0; i < E; i++)
+    {
+        sorted[i] = edges[orderIn[i]];
+    }
+    memcpy(edges, sorted, (size_t)E * sizeof(Edge));
+
+    free(keys);
+    free(order);
+    free(sorted);
+    return true;
+}
+
+// Edge ordering key: the weight (sign bit flipped) in the high half and the
+// edge index in the low half. All keys are distinct, and sorting them gives
+// the order of a stable sort by weight.
+static uint64_t edgeKey(const Edge *edge, uint32_t index)
+{
+    return ((uint64_t)((uint32_t)edge->weight ^ 0x80000000u) << 32) | index;
+}
+
+// LSD radix sort of n keys, skipping digits that are the same in all keys
+static void sortKeys(uint64_t keys[], size_t n, uint64_t scratch[])
+{
+    uint64_t *in = keys, *out = scratch;
+    for (int shift = 0; shift < 64; shift += RADIX_BITS)
+    {
+        size_t count[RADIX_BUCKETS] = {0};
+        for (size_t i = 0; i < n; i++)
+        {
+            count[(in[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+        }
+        if (count[(in[0] >> shift) & (RADIX_BUCKETS - 1)] == n)
+            continue;
+
+        size_t position = 0;
+        for (int d = 0; d < RADIX_BUCKETS; d++)
+        {
+            size_t bucketSize = count[d];
+            count[d] = position;
+            position += bucketSize;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            out[count[(in[i] >> shift) & (RADIX_BUCKETS - 1)]++] = in[i];
+        }
+
+        uint64_t *temp = in;
+        in = out;
+        out = temp;
+    }
+    if (in != keys)
+    {
+        memcpy(keys, in, n * sizeof(uint64_t));
     }
 }
 
 // Kruskal's MST Algorithm
-void kruskalMST(int V, int E, Edge edges[])
+// Nothing is printed and the caller's edges are not changed: the edges are
+// ordered through a separate array of 64-bit keys. trace, if not NULL, is
+// called for every edge in sorted order (KRUSKAL_SORTED) and then for every
+// decision, so console output costs nothing unless it is asked for.
+bool kruskal(int V, int E, const Edge edges[], Edge mst[], KruskalResult *result,
+             KruskalTrace trace, void *context)
 {
-    Edge mst[V]; // to store MST edges (maximum V-1 edges)
-    int mstEdgeCount = 0;
-    int totalCost = 0;
+    result->edges = mst;
+    result->edgeCount = 0;
+    result->totalCost = 0;
+    result->allocated = false;
+    if (V <= 0)
+        return true;
+    if (E < 0)
+        E = 0;
+
+    if (mst == NULL)
+    {
+        result->edges = malloc((size_t)V * sizeof(Edge));
+        result->allocated = true;
+    }
+    uint64_t *keys = malloc(((size_t)E > 0 ? (size_t)E : 1) * sizeof(uint64_t));
+    uint64_t *scratch = malloc(((size_t)E > 0 ? (size_t)E : 1) * sizeof(uint64_t));
+    DisjointSet *set = makeDisjointSet((uint32_t)V);
+    if (result->edges == NULL || keys == NULL || scratch == NULL || set == NULL)
+    {
+        free(keys);
+        free(scratch);
+        freeDisjointSet(set);
+        freeKruskalResult(result);
+        return false;
+    }
 
     // Sort all edges by increasing weight
-    sortEdgesByWeight(edges, E);
+    for (int i = 0; i < E; i++)
+    {
+        keys[i] = edgeKey(&edges[i], (uint32_t)i);
+    }
+    sortKeys(keys, (size_t)E, scratch);
+    free(scratch);
+
+    if (trace != NULL)
+    {
+        for (int i = 0; i < E; i++)
+        {
+            trace(KRUSKAL_SORTED, &edges[(uint32_t)keys[i]], context);
+        }
+    }
+
+    for (int i = 0; i < E && result->edgeCount < V - 1; i++)
+    {
+        const Edge *edge = &edges[(uint32_t)keys[i]];
+        KruskalEvent event;
+        if (edge->src < 0 || edge->src >= V || edge->dest < 0 || edge->dest >= V)
+        {
+            event = KRUSKAL_SKIPPED;
+        }
+        else if (unionSet(set, (uint32_t)edge->src, (uint32_t)edge->dest))
+        {
+            event = KRUSKAL_ACCEPTED;
+            result->edges[result->edgeCount++] = *edge;
+            result->totalCost += edge->weight;
+        }
+        else
+        {
+            event = KRUSKAL_REJECTED;
+        }
+        if (trace != NULL)
+            trace(event, edge, context);
+    }
+
+    free(keys);
+    freeDisjointSet(set);
+    return true;
+}
+
+void freeKruskalResult(KruskalResult *result)
+{
+    if (result->allocated)
+        free(result->edges);
+    result->edges = NULL;
+    result->edgeCount = 0;
+    result->allocated = false;
+}
+
+// Console trace of kruskalMST: the sorted list, then every decision
+static void printKruskalStep(KruskalEvent event, const Edge *edge, void *context)
+{
+    bool *selecting = (bool *)context;
+    if (event == KRUSKAL_SORTED)
+    {
+        printf("%d -- %d  (cost = %d)\n", edge->src, edge->dest, edge->weight);
+        return;
+    }
+    if (!*selecting)
+    {
+        printf("\n=== Selecting edges for Minimum Spanning Tree (Kruskal) ===\n");
+        *selecting = true;
+    }
+
+    printf("\nConsidering edge %d -- %d (cost = %d)\n", edge->src, edge->dest, edge->weight);
+    switch (event)
+    {
+    case KRUSKAL_ACCEPTED:
+        printf(" → Accepted (no cycle formed)\n");
+        break;
+    case KRUSKAL_REJECTED:
+        printf(" → Rejected (would form a cycle)\n");
+        break;
+    default:
+        printf(" → Skipped (vertex out of range)\n");
+        break;
+    }
+}
+
+// Kruskal with the full step-by-step console report
+void kruskalMST(int V, int E, Edge edges[])
+{
+    if (V <= 0)
+        return;
 
+    KruskalResult result;
+    bool selecting = false;
     printf("\nEdges sorted by weight (candidate roads):\n");
-    for (int i = 0; i < E; i++)
+    if (!kruskal(V, E, edges, NULL, &result, printKruskalStep, &selecting))
+    {
+        fprintf(stderr, "Not enough memory for %d vertices and %d edges\n", V, E);
+        return;
+    }
+    if (!selecting)
+    {
+        printf("\n=== Selecting edges for Minimum Spanning Tree (Kruskal) ===\n");
+    }
+
+    printf("\n=== Final Minimum Spanning Tree (Road Network) ===\n");
+    printf("Edge\tCost\n");
+    printf("-----------------\n");
+    for (int i = 0; i < result.edgeCount; i++)
+    {
+        printf("%d -- %d\t%d\n", result.edges[i].src, result.edges[i].dest, result.edges[i].weight);
+    }
+    printf("-----------------\n");
+    printf("Total Minimum Cost = %lld\n", result.totalCost);
+
+    if (result.edgeCount != V - 1)
     {
-        printf("%d -- %d  (cost = %d)\n", edges[i].src, edges[i].dest, edges[i].weight);
+        printf("\nNote: Graph was not fully connected, MST could not include all vertices.\n");
     }
+    freeKruskalResult(&result);
+}
+
+// ---------------- Filter-Kruskal ----------------
+// Sorting all E edges wastes time on dense graphs, because most heavy edges
+// are rejected anyway. Filter-Kruskal partitions the edges around a random
+// pivot weight and solves the light part first. From the heavy part it then
+// drops every edge whose endpoints are already connected, and only
+// continues with what is left. Small parts are radix-sorted and scanned as
+// in kruskalMST.
+//
+// Every edge is handled as a 64-bit key: the weight (sign bit flipped) in
+// the high half and the edge index in the low half. All keys are distinct
+// and their order is the order of kruskalMST's stable sort, so both
+// functions accept exactly the same edges.
 
-    makeSet(V);
+// Parts with at most this many edges are sorted instead of split
+#define FILTER_KRUSKAL_BASE 1024
 
-    printf("\n=== Selecting edges for Minimum Spanning Tree (Kruskal) ===\n");
+typedef struct
+{
+    const Edge *edges;
+    DisjointSet *set;
+    Edge *mst;
+    int mstEdgeCount;
+    int target;              // V - 1
+    long long totalCost;
+    uint64_t *scratch;       // Radix sort buffer, as long as the key array
+    uint32_t seed;           // xorshift state for pivot sampling
+} FilterKruskal;
 
-    for (int i = 0; i < E && mstEdgeCount < V - 1; i++)
+// Plain Kruskal on a small part
+static void kruskalBase(FilterKruskal *fk, uint64_t keys[], size_t n)
+{
+    if (n == 0)
+        return;
+    sortKeys(keys, n, fk->scratch);
+    for (size_t i = 0; i < n && fk->mstEdgeCount < fk->target; i++)
     {
-        int u = edges[i].src;
-        int v = edges[i].dest;
-        int w = edges[i].weight;
+        const Edge *edge = &fk->edges[(uint32_t)keys[i]];
+        if (unionSet(fk->set, (uint32_t)edge->src, (uint32_t)edge->dest))
+        {
+            fk->mst[fk->mstEdgeCount++] = *edge;
+            fk->totalCost += edge->weight;
+        }
+    }
+}
 
-        int setU = findSet(u);
-        int setV = findSet(v);
+// Median of three random keys
+static uint64_t choosePivot(FilterKruskal *fk, const uint64_t keys[], size_t n)
+{
+    uint64_t sample[3];
+    for (int s = 0; s < 3; s++)
+    {
+        fk->seed ^= fk->seed << 13;
+        fk->seed ^= fk->seed >> 17;
+        fk->seed ^= fk->seed << 5;
+        sample[s] = keys[fk->seed % n];
+    }
+    if (sample[0] > sample[1])
+    {
+        uint64_t temp = sample[0];
+        sample[0] = sample[1];
+        sample[1] = temp;
+    }
+    if (sample[1] > sample[2])
+        sample[1] = sample[2] > sample[0] ? sample[2] : sample[0];
+    return sample[1];
+}
 
-        printf("\nConsidering edge %d -- %d (cost = %d)\n", u, v, w);
+// Moves keys <= pivot to the front; returns how many there are
+static size_t partitionKeys(uint64_t keys[], size_t n, uint64_t pivot)
+{
+    size_t light = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (keys[i] <= pivot)
+        {
+            uint64_t temp = keys[light];
+            keys[light++] = keys[i];
+            keys[i] = temp;
+        }
+    }
+    return light;
+}
 
-        if (setU != setV)
+// Keeps only the edges whose endpoints are still in different sets
+static size_t filterKeys(FilterKruskal *fk, uint64_t keys[], size_t n)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const Edge *edge = &fk->edges[(uint32_t)keys[i]];
+        if (!sameSet(fk->set, (uint32_t)edge->src, (uint32_t)edge->dest))
         {
-            printf(" → Accepted (no cycle formed)\n");
-            mst[mstEdgeCount++] = edges[i];
-            totalCost += w;
-            unionSet(setU, setV);
+            keys[kept++] = keys[i];
         }
-        else
+    }
+    return kept;
+}
+
+static void filterKruskalPart(FilterKruskal *fk, uint64_t keys[], size_t n)
+{
+    // The light part recurses; the heavy part is handled by this loop
+    while (n > FILTER_KRUSKAL_BASE && fk->mstEdgeCount < fk->target)
+    {
+        size_t light = partitionKeys(keys, n, choosePivot(fk, keys, n));
+        if (light == 0 || light == n)
+            break;
+        filterKruskalPart(fk, keys, light);
+        keys += light;
+        n = filterKeys(fk, keys, n - light);
+    }
+    if (fk->mstEdgeCount < fk->target)
+    {
+        kruskalBase(fk, keys, n);
+    }
+}
+
+// Computes the MST without printing. mst must have room for V - 1 edges.
+// Returns the number of MST edges, or -1 if out of memory. The caller's
+// edge array is not modified.
+int filterKruskal(int V, int E, const Edge edges[], Edge mst[], long long *totalCost)
+{
+    *totalCost = 0;
+    if (V <= 0 || E <= 0)
+        return 0;
+
+    uint64_t *keys = malloc((size_t)E * sizeof(uint64_t));
+    uint64_t *scratch = malloc((size_t)E * sizeof(uint64_t));
+    DisjointSet *set = makeDisjointSet((uint32_t)V);
+    if (keys == NULL || scratch == NULL || set == NULL)
+    {
+        free(keys);
+        free(scratch);
+        freeDisjointSet(set);
+        return -1;
+    }
+
+    // Edges with an endpoint out of range are skipped, as in kruskalMST
+    size_t n = 0;
+    for (int i = 0; i < E; i++)
+    {
+        if (edges[i].src >= 0 && edges[i].src < V && edges[i].dest >= 0 && edges[i].dest < V)
         {
-            printf(" → Rejected (would form a cycle)\n");
+            keys[n++] = edgeKey(&edges[i], (uint32_t)i);
         }
     }
 
+    FilterKruskal fk = {edges, set, mst, 0, V - 1, 0, scratch, 2463534242u};
+    filterKruskalPart(&fk, keys, n);
+
+    free(keys);
+    free(scratch);
+    freeDisjointSet(set);
+    *totalCost = fk.totalCost;
+    return fk.mstEdgeCount;
+}
+
+// Filter-Kruskal with the same final report as kruskalMST. The filtered
+// edges are never sorted, so there is no sorted list or per-edge trace.
+void filterKruskalMST(int V, int E, Edge edges[])
+{
+    if (V <= 0)
+        return;
+
+    Edge *mst = malloc((size_t)V * sizeof(Edge));
+    long long totalCost;
+    int mstEdgeCount = mst != NULL ? filterKruskal(V, E, edges, mst, &totalCost) : -1;
+    if (mstEdgeCount < 0)
+    {
+        fprintf(stderr, "Not enough memory for %d vertices and %d edges\n", V, E);
+        free(mst);
+        return;
+    }
+
     printf("\n=== Final Minimum Spanning Tree (Road Network) ===\n");
     printf("Edge\tCost\n");
     printf("-----------------\n");
@@ -104,10 +549,340 @@ void kruskalMST(int V, int E, Edge edges[])
         printf("%d -- %d\t%d\n", mst[i].src, mst[i].dest, mst[i].weight);
     }
     printf("-----------------\n");
-    printf("Total Minimum Cost = %d\n", totalCost);
+    printf("Total Minimum Cost = %lld\n", totalCost);
 
     if (mstEdgeCount != V - 1)
     {
         printf("\nNote: Graph was not fully connected, MST could not include all vertices.\n");
     }
+    free(mst);
+}
+
+// ---------------- Semi-external Kruskal ----------------
+// For edge lists larger than RAM while the vertex set still fits. The edge
+// file is a plain array of Edge records (src, dest, weight as 32-bit ints,
+// native byte order) and is memory-mapped. It is cut into runs of
+// runEdges edges (by default as many as fit in EXTERNAL_RUN_BYTES together
+// with their sort scratch), and each run is radix-sorted in memory and
+// appended to "<mstFile>.runs". The runs are then merged with a min-heap, and the
+// merged order streams through a DisjointSet. Accepted edges go straight
+// to mstFile in the same record format. Equal weights are taken in file
+// order, so the MST is the one kruskalMST would choose.
+
+typedef struct
+{
+    const char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+static bool mapFile(const char *filename, MappedFile *mf)
+{
+    mf->data = NULL;
+    mf->size = 0;
+#ifdef _WIN32
+    mf->mapping = NULL;
+    mf->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mf->file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mf->file, &size))
+    {
+        CloseHandle(mf->file);
+        return false;
+    }
+    mf->size = (size_t)size.QuadPart;
+    if (mf->size == 0)
+        return true;
+    mf->mapping = CreateFileMappingA(mf->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mf->mapping)
+        mf->data = (const char *)MapViewOfFile(mf->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (mf->data == NULL)
+    {
+        if (mf->mapping)
+            CloseHandle(mf->mapping);
+        CloseHandle(mf->file);
+        return false;
+    }
+#else
+    mf->fd = open(filename, O_RDONLY);
+    if (mf->fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(mf->fd, &st) != 0)
+    {
+        close(mf->fd);
+        return false;
+    }
+    mf->size = (size_t)st.st_size;
+    if (mf->size == 0)
+        return true;
+    void *data = mmap(NULL, mf->size, PROT_READ, MAP_PRIVATE, mf->fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(mf->fd);
+        return false;
+    }
+    madvise(data, mf->size, MADV_SEQUENTIAL);
+    mf->data = (const char *)data;
+#endif
+    return true;
+}
+
+static void unmapFile(MappedFile *mf)
+{
+#ifdef _WIN32
+    if (mf->data)
+        UnmapViewOfFile(mf->data);
+    if (mf->mapping)
+        CloseHandle(mf->mapping);
+    CloseHandle(mf->file);
+#else
+    if (mf->data)
+        munmap((void *)mf->data, mf->size);
+    close(mf->fd);
+#endif
+}
+
+// Smallest unread edge of one run
+typedef struct
+{
+    Edge edge;
+    uint32_t run;
+} MergeHead;
+
+// Lower weight first; on equal weights the earlier run, i.e. file order
+static bool headBefore(const MergeHead *a, const MergeHead *b)
+{
+    if (a->edge.weight != b->edge.weight)
+        return a->edge.weight < b->edge.weight;
+    return a->run < b->run;
+}
+
+static void siftDown(MergeHead heap[], size_t count, size_t i)
+{
+    MergeHead item = heap[i];
+    for (;;)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && headBefore(&heap[child + 1], &heap[child]))
+            child++;
+        if (!headBefore(&heap[child], &item))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = item;
+}
+
+// Merges the sorted runs data[runStart[r] .. runStart[r + 1]) through the
+// disjoint set and writes the accepted edges to out. False if out of memory.
+static bool mergeRuns(const Edge *data, const size_t runStart[], uint32_t runs, DisjointSet *set,
+                      FILE *out, ExternalKruskalStats *stats)
+{
+    MergeHead *heap = malloc((runs > 0 ? runs : 1) * sizeof(MergeHead));
+    size_t *next = malloc((runs > 0 ? runs : 1) * sizeof(size_t));
+    if (heap == NULL || next == NULL)
+    {
+        free(heap);
+        free(next);
+        return false;
+    }
+
+    size_t count = 0;
+    for (uint32_t r = 0; r < runs; r++)
+    {
+        next[r] = runStart[r];
+        if (next[r] < runStart[r + 1])
+        {
+            heap[count].edge = data[next[r]++];
+            heap[count].run = r;
+            count++;
+        }
+    }
+    for (size_t i = count / 2; i-- > 0;)
+    {
+        siftDown(heap, count, i);
+    }
+
+    uint32_t target = set->size - 1;
+    while (count > 0 && (uint32_t)stats->mstEdgeCount < target)
+    {
+        const Edge *edge = &heap[0].edge;
+        if (unionSet(set, (uint32_t)edge->src, (uint32_t)edge->dest))
+        {
+            fwrite(edge, sizeof(Edge), 1, out);
+            stats->mstEdgeCount++;
+            stats->totalCost += edge->weight;
+        }
+
+        uint32_t r = heap[0].run;
+        if (next[r] < runStart[r + 1])
+            heap[0].edge = data[next[r]++];
+        else
+            heap[0] = heap[--count];
+        siftDown(heap, count, 0);
+    }
+
+    free(heap);
+    free(next);
+    return true;
+}
+
+bool externalKruskal(int V, const char *edgeFile, const char *mstFile, size_t runEdges,
+                     ExternalKruskalStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (V <= 0)
+    {
+        fprintf(stderr, "Invalid vertex count %d\n", V);
+        return false;
+    }
+    if (runEdges == 0)
+        runEdges = EXTERNAL_RUN_BYTES / (sizeof(Edge) + EDGE_SORT_SCRATCH);
+    if (runEdges > INT32_MAX)
+        runEdges = INT32_MAX;
+
+    MappedFile input;
+    if (!mapFile(edgeFile, &input))
+    {
+        fprintf(stderr, "Cannot open edge file: %s\n", edgeFile);
+        return false;
+    }
+    if (input.size % sizeof(Edge) != 0)
+    {
+        fprintf(stderr, "%s is not a list of %zu-byte edge records\n", edgeFile, sizeof(Edge));
+        unmapFile(&input);
+        return false;
+    }
+    const Edge *edges = (const Edge *)input.data;
+    size_t edgeCount = input.size / sizeof(Edge);
+    stats->edgesRead = (long long)edgeCount;
+
+    size_t maxRuns = edgeCount / runEdges + 1;
+    size_t *runStart = malloc((maxRuns + 1) * sizeof(size_t));
+    Edge *run = malloc((edgeCount < runEdges ? (edgeCount > 0 ? edgeCount : 1) : runEdges) * sizeof(Edge));
+    DisjointSet *set = makeDisjointSet((uint32_t)V);
+    FILE *out = NULL;
+    if (runStart == NULL || run == NULL || set == NULL)
+    {
+        fprintf(stderr, "Not enough memory for %d vertices and runs of %zu edges\n", V, runEdges);
+    }
+    else if ((out = fopen(mstFile, "wb")) == NULL)
+    {
+        fprintf(stderr, "Cannot create file: %s\n", mstFile);
+    }
+    if (out == NULL)
+    {
+        free(runStart);
+        free(run);
+        freeDisjointSet(set);
+        unmapFile(&input);
+        return false;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+
+    // Phase 1: sorted runs. Edges with an endpoint out of range are skipped,
+    // as in kruskalMST. A single run stays in memory.
+    char runsPath[1024];
+    snprintf(runsPath, sizeof(runsPath), "%s.runs", mstFile);
+    FILE *runsFile = NULL;
+    bool ok = true;
+    uint32_t runs = 0;
+    size_t written = 0;
+    for (size_t first = 0; first < edgeCount && ok; first += runEdges)
+    {
+        size_t last = first + runEdges < edgeCount ? first + runEdges : edgeCount;
+        size_t n = 0;
+        for (size_t i = first; i < last; i++)
+        {
+            if (edges[i].src >= 0 && edges[i].src < V && edges[i].dest >= 0 && edges[i].dest < V)
+            {
+                run[n++] = edges[i];
+            }
+        }
+        if (!sortEdgesByWeight(run, (int)n))
+        {
+            fprintf(stderr, "Not enough memory to sort a run of %zu edges\n", n);
+            ok = false;
+            break;
+        }
+        runStart[runs++] = written;
+        written += n;
+
+        if (last < edgeCount || runsFile != NULL)
+        {
+            if (runsFile == NULL)
+            {
+                runsFile = fopen(runsPath, "wb");
+                if (runsFile == NULL)
+                {
+                    fprintf(stderr, "Cannot create file: %s\n", runsPath);
+                    ok = false;
+                    break;
+                }
+            }
+            if (fwrite(run, sizeof(Edge), n, runsFile) != n)
+            {
+                fprintf(stderr, "Failed to write %s\n", runsPath);
+                ok = false;
+            }
+        }
+    }
+    runStart[runs] = written;
+    stats->runs = (int)runs;
+    unmapFile(&input);
+
+    // Phase 2: merge the runs through the disjoint set
+    bool merged = false;
+    if (ok && runsFile == NULL)
+    {
+        merged = mergeRuns(run, runStart, runs, set, out, stats);
+    }
+    else if (ok)
+    {
+        free(run);
+        run = NULL;
+        MappedFile sorted;
+        if (fclose(runsFile) != 0 || !mapFile(runsPath, &sorted))
+        {
+            fprintf(stderr, "Cannot read back %s\n", runsPath);
+            ok = false;
+        }
+        else
+        {
+            merged = mergeRuns((const Edge *)sorted.data, runStart, runs, set, out, stats);
+            unmapFile(&sorted);
+        }
+        runsFile = NULL;
+    }
+    if (runsFile)
+        fclose(runsFile);
+    remove(runsPath);
+    if (ok && !merged)
+    {
+        fprintf(stderr, "Not enough memory to merge %u runs\n", runs);
+        ok = false;
+    }
+
+    bool writeFailed = ferror(out) != 0;
+    if (fclose(out) != 0 || writeFailed)
+    {
+        if (ok)
+            fprintf(stderr, "Failed to write %s\n", mstFile);
+        ok = false;
+    }
+
+    free(runStart);
+    free(run);
+    freeDisjointSet(set);
+    return ok;
 }
@@ -1,6 +1,11 @@
 #ifndef KRUSKAL_H
 #define KRUSKAL_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 // Edge structure: represents a road between two cities/buildings
 typedef struct
 {
@@ -9,6 +14,100 @@ typedef struct
     int weight;
 } Edge;
 
-void kruskalMST(int V, int E, Edge edges[]);
+// Disjoint Set (Union-Find) over vertices 0..size-1.
+// Every instance owns its arrays, so separate instances can be used from
+// separate threads; one instance must not be shared between threads.
+typedef struct
+{
+    uint32_t *parent;
+    uint8_t *rank;        // Tree height bound; stays below 32
+    uint32_t size;
+    uint32_t components;  // Number of disjoint sets left
+} DisjointSet;
+
+DisjointSet *makeDisjointSet(uint32_t n);   // NULL if out of memory
+void freeDisjointSet(DisjointSet *set);
+uint32_t findSet(DisjointSet *set, uint32_t v);
+bool unionSet(DisjointSet *set, uint32_t a, uint32_t b);  // false if already joined
+bool sameSet(DisjointSet *set, uint32_t a, uint32_t b);
+uint32_t componentCount(const DisjointSet *set);
+
+// Concurrent Disjoint Set (concurrent_union_find.c, needs -pthread).
+// Any number of threads may call find/union/sameSet on one instance at
+// the same time; the operations are lock-free (CAS on parent links).
+typedef struct
+{
+    _Atomic uint32_t *parent;
+    uint32_t size;
+} ConcurrentDisjointSet;
+
+ConcurrentDisjointSet *makeConcurrentDisjointSet(uint32_t n);   // NULL if out of memory
+void freeConcurrentDisjointSet(ConcurrentDisjointSet *set);
+uint32_t concurrentFind(ConcurrentDisjointSet *set, uint32_t v);
+bool concurrentUnion(ConcurrentDisjointSet *set, uint32_t a, uint32_t b);  // false if already joined
+bool concurrentSameSet(ConcurrentDisjointSet *set, uint32_t a, uint32_t b);
+int getCpuCount(void);
+
+// Connected components of an edge list on `threads` threads (0 = all CPUs).
+// Returns the number of components, or -1 if out of memory. If labels is
+// not NULL, labels[v] receives a vertex id shared by v's whole component.
+long long parallelComponents(int V, size_t E, const Edge edges[], int threads, uint32_t labels[]);
+
+// Stable, linear-time radix sort. Uses EDGE_SORT_SCRATCH extra bytes per
+// edge and returns false, leaving edges as they were, if that is not available.
+#define EDGE_SORT_SCRATCH (2 * sizeof(unsigned int) + 2 * sizeof(int) + sizeof(Edge))
+bool sortEdgesByWeight(Edge edges[], int E);
+
+// Result of kruskal(): accepted edges, cheapest first
+typedef struct
+{
+    Edge *edges;
+    int edgeCount;
+    long long totalCost;
+    bool allocated;       // edges was allocated by kruskal()
+} KruskalResult;
+
+// Optional step-by-step trace of kruskal()
+typedef enum
+{
+    KRUSKAL_SORTED,       // Every edge once, in sorted order, before selection
+    KRUSKAL_ACCEPTED,
+    KRUSKAL_REJECTED,     // Would form a cycle
+    KRUSKAL_SKIPPED       // Endpoint out of range
+} KruskalEvent;
+
+typedef void (*KruskalTrace)(KruskalEvent event, const Edge *edge, void *context);
+
+// Computes the MST without printing and without modifying edges. mst must
+// have room for V - 1 edges, or be NULL to have one allocated (release it
+// with freeKruskalResult). trace may be NULL. Returns false if out of memory.
+bool kruskal(int V, int E, const Edge edges[], Edge mst[], KruskalResult *result,
+             KruskalTrace trace, void *context);
+void freeKruskalResult(KruskalResult *result);
+
+void kruskalMST(int V, int E, Edge edges[]);   // kruskal() with a full console trace
+
+// Filter-Kruskal: same MST as kruskalMST, but heavy edges that would only
+// close cycles are filtered out instead of sorted. Better on dense graphs.
+int filterKruskal(int V, int E, const Edge edges[], Edge mst[], long long *totalCost);
+void filterKruskalMST(int V, int E, Edge edges[]);
+
+// Semi-external Kruskal for edge files larger than memory: edgeFile holds
+// raw Edge records, runEdges of them are sorted in memory at a time
+// (0 = as many as fit in EXTERNAL_RUN_BYTES, counting the run itself and
+// its sort scratch), and MST edges are written to mstFile in the same
+// format as they are found. Returns false on a file or memory error.
+#define EXTERNAL_RUN_BYTES (192u << 20)
+
+typedef struct
+{
+    long long edgesRead;
+    int runs;                // Sorted runs the file was cut into
+    int mstEdgeCount;
+    long long totalCost;
+} ExternalKruskalStats;
+
+bool externalKruskal(int V, const char *edgeFile, const char *mstFile, size_t runEdges,
+                     ExternalKruskalStats *stats);
 
 #endif
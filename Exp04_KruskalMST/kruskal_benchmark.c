@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "kruskal.h"
+
+// Filter-Kruskal benchmark on dense random graphs.
+// For V = 500, 1000, 2000, ... up to max_vertices it builds a graph with
+// `density` percent of all V(V-1)/2 possible roads (random costs) and times
+// kruskal (radix sort of every edge, then union-find) against filterKruskal,
+// checking that both pick exactly the same MST edges.
+//
+// Usage: kruskal_benchmark [max_vertices] [density_percent]
+
+static double elapsedSeconds(struct timespec start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static Edge *buildDenseGraph(int V, int density, int *E)
+{
+    size_t capacity = (size_t)V * (V - 1) / 2;
+    Edge *edges = malloc(capacity * sizeof(Edge));
+    if (edges == NULL)
+        return NULL;
+
+    size_t count = 0;
+    for (int u = 0; u < V; u++)
+    {
+        for (int v = u + 1; v < V; v++)
+        {
+            if (rand() % 100 < density)
+            {
+                edges[count].src = u;
+                edges[count].dest = v;
+                edges[count].weight = 1 + rand() % 1000000;
+                count++;
+            }
+        }
+    }
+    *E = (int)count;
+    return edges;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxVertices = argc > 1 ? atoi(argv[1]) : 4000;
+    int density = argc > 2 ? atoi(argv[2]) : 100;
+    if (maxVertices < 500)
+        maxVertices = 500;
+    if (density < 1 || density > 100)
+        density = 100;
+
+    printf("\nKruskal on dense random graphs (%d%% of all possible roads)\n", density);
+    printf("┌──────────┬────────────┬─────────────┬────────────────┬──────────┬───────────┐\n");
+    printf("│ Vertices │ Edges      │ Sorting (s) │ Filtering (s)  │ Speedup  │ Same MST  │\n");
+    printf("├──────────┼────────────┼─────────────┼────────────────┼──────────┼───────────┤\n");
+
+    srand(42);
+    for (int V = 500; V <= maxVertices; V *= 2)
+    {
+        int E;
+        Edge *edges = buildDenseGraph(V, density, &E);
+        Edge *sortedMst = malloc((size_t)V * sizeof(Edge));
+        Edge *filteredMst = malloc((size_t)V * sizeof(Edge));
+        if (edges == NULL || sortedMst == NULL || filteredMst == NULL)
+        {
+            fprintf(stderr, "Not enough memory for %d vertices\n", V);
+            return 1;
+        }
+
+        KruskalResult sorted;
+        long long filteredCost = 0;
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool sortedOk = kruskal(V, E, edges, sortedMst, &sorted, NULL, NULL);
+        double sortTime = elapsedSeconds(start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int filteredCount = filterKruskal(V, E, edges, filteredMst, &filteredCost);
+        double filterTime = elapsedSeconds(start);
+
+        int same = sortedOk && sorted.edgeCount == filteredCount && sorted.totalCost == filteredCost &&
+                   memcmp(sortedMst, filteredMst, (size_t)sorted.edgeCount * sizeof(Edge)) == 0;
+        printf("│ %8d │ %10d │ %11.3f │ %14.3f │ %7.2fx │ %-9s │\n",
+               V, E, sortTime, filterTime, sortTime / filterTime, same ? "yes" : "NO");
+        fflush(stdout);
+
+        free(edges);
+        free(sortedMst);
+        free(filteredMst);
+        if (!same)
+            return 1;
+    }
+    printf("└──────────┴────────────┴─────────────┴────────────────┴──────────┴───────────┘\n");
+    return 0;
+}
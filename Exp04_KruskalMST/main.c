@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "kruskal.h"
 
 /*
@@ -39,11 +40,48 @@ void loadDemoGraph(int *V, int *E, Edge edges[])
     printf("Vertices (0-4): 0-Admin, 1-CSE, 2-Library, 3-Hostel, 4-Workshop\n");
 }
 
-int main()
+/*
+   Semi-external mode for edge files larger than memory:
+   exp4 --external V edges.bin mst.bin [edges_per_run]
+*/
+int runExternalMode(int argc, char *argv[])
+{
+    if (argc < 5 || strcmp(argv[1], "--external") != 0)
+    {
+        fprintf(stderr, "Usage: %s                                      interactive menu\n", argv[0]);
+        fprintf(stderr, "       %s --external V edges.bin mst.bin [edges_per_run]\n", argv[0]);
+        return 2;
+    }
+
+    int V = atoi(argv[2]);
+    size_t runEdges = argc > 5 ? (size_t)strtoull(argv[5], NULL, 10) : 0;
+    ExternalKruskalStats stats;
+    if (!externalKruskal(V, argv[3], argv[4], runEdges, &stats))
+    {
+        return 1;
+    }
+
+    printf("Edges read         = %lld\n", stats.edgesRead);
+    printf("Sorted runs        = %d\n", stats.runs);
+    printf("MST edges written  = %d (to %s)\n", stats.mstEdgeCount, argv[4]);
+    printf("Total Minimum Cost = %lld\n", stats.totalCost);
+    if (stats.mstEdgeCount != V - 1)
+    {
+        printf("\nNote: Graph was not fully connected, MST could not include all vertices.\n");
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
 {
     int V, E, choice;
     Edge edges[100];  // adjust size if needed
 
+    if (argc > 1)
+    {
+        return runExternalMode(argc, argv);
+    }
+
     while (1)
     {
         printf("\n===== Experiment 4 - Kruskal's Algorithm (MST) =====\n");